@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <sys/stat.h>
+#include "gsl/gsl_rng.h"
+#include "gsl/gsl_randist.h"
+#include "benchmark.h"
+#include "chamber.h"
+#include "defect.h"
+#include "lattice.h"
+#include "neurongen.h"
+#include "profiler.h"
+
+// Bundled patterns used by the macro benchmarks
+static const char* const MACRO_PATTERNS[] = {"circ", "smiley", "square_periodic", "patternBord200", "singlecirc"};
+static const int MACRO_PATTERN_COUNT = 5;
+static const char* const DEFECT_NAMES[] = {"disk", "rectangle", "chain", "pixel", "segment"};
+
+// Intersection tests per type pair
+#define BENCHMARK_INTERSECTIONS 1000000
+// Sample defects per type
+#define BENCHMARK_DEFECTS 1024
+
+Benchmark::Benchmark(const neuron::generationParameters& base)
+{
+    params = base;
+    params.seed = 1;
+    repeats = 3;
+}
+
+// Keeps the best time of every benchmark
+void Benchmark::addResult(std::string name, int64_t operations, double seconds)
+{
+    for(std::vector<result>::iterator i = results.begin(); i != results.end(); i++)
+    {
+        if(i->name == name)
+        {
+            if(seconds < i->seconds)
+                i->seconds = seconds;
+            return;
+        }
+    }
+    result newResult = {name, operations, seconds};
+    results.push_back(newResult);
+}
+
+// Base parameters on a pattern without density map
+neuron::generationParameters Benchmark::patternParameters(const neuron::generationParameters& base,
+                                                          std::string patternFile, int neurons)
+{
+    neuron::generationParameters p = base;
+    p.chamber.pattern = true;
+    p.chamber.patternFile = patternFile;
+    p.chamber.type = neuron::CH_TYPE_CUSTOM;
+    p.chamber.densityMap = false;
+    p.culture.neuronNumber = neurons;
+    return p;
+}
+
+void Benchmark::runMicro(std::string patternFile, int neurons)
+{
+    for(int r = 0; r < repeats; r++)
+    {
+        benchmarkLattice(neurons);
+        benchmarkIntersections();
+        benchmarkChamber(patternFile, neurons);
+    }
+}
+
+// addDefect with soma sized disks, then range queries of the size of a
+// dendritic tree around random points
+void Benchmark::benchmarkLattice(int neurons)
+{
+    double width = params.chamber.width, height = params.chamber.height > 0 ? params.chamber.height : width;
+    double cell = params.soma.radius*3.;
+    Lattice lattice(neuron::LATTICE_BOUNDARIES_PERIODIC, Vector2d(-width/2., height/2.), cell, cell, width, height);
+    gsl_rng* rng = gsl_rng_alloc(gsl_rng_taus2);
+    std::vector<Defect> defects;
+    std::vector<Vector2d> bounds(2);
+    double start, radius = params.dtree.meanRadius;
+    int64_t candidates = 0;
+
+    gsl_rng_set(rng, 1);
+    for(int i = 0; i < neurons; i++)
+    {
+        Vector2d position(gsl_ran_flat(rng, -width/2., width/2.), gsl_ran_flat(rng, -height/2., height/2.));
+        defects.push_back(Defect(DEFECT_TYPE_DISK, DEFECT_CLASS_SOMA, 0, std::vector<double>(1, params.soma.radius),
+                                 std::vector<Vector2d>(1, position), i));
+    }
+    start = Profiler::wallTime();
+    for(int i = 0; i < neurons; i++)
+        lattice.addDefect(defects[i]);
+    addResult("micro/lattice_add_defect", neurons, Profiler::wallTime()-start);
+
+    start = Profiler::wallTime();
+    for(int i = 0; i < neurons; i++)
+    {
+        Vector2d position = defects[i].getPoints().at(0);
+        bounds[0] = position-Vector2d(radius, radius);
+        bounds[1] = position+Vector2d(radius, radius);
+        candidates += lattice.getDefectsInRange(bounds).size();
+    }
+    addResult("micro/lattice_range_query", neurons, Profiler::wallTime()-start);
+    gsl_rng_free(rng);
+}
+
+// Every (defect, tested defect) type pair on random defects of soma and
+// segment sizes in a small box, so some of them intersect
+void Benchmark::benchmarkIntersections()
+{
+    gsl_rng* rng = gsl_rng_alloc(gsl_rng_taus2);
+    std::vector<Defect> defects[PROFILE_DEFECT_TYPES];
+    double size = params.soma.radius, box = 10*size, start;
+    volatile int64_t hits = 0;
+
+    gsl_rng_set(rng, 1);
+    for(int k = 0; k < BENCHMARK_DEFECTS; k++)
+    {
+        Vector2d p(gsl_ran_flat(rng, -box, box), gsl_ran_flat(rng, -box, box));
+        Vector2d d(gsl_ran_flat(rng, -size, size), gsl_ran_flat(rng, -size, size));
+        std::vector<double> two(2, size);
+        std::vector<Vector2d> chain, segment;
+        chain.push_back(p);
+        chain.push_back(p+d);
+        chain.push_back(p+2*d);
+        segment.push_back(p);
+        segment.push_back(p+4*d);
+        defects[DEFECT_TYPE_DISK].push_back(Defect(DEFECT_TYPE_DISK, DEFECT_CLASS_SOMA, 0,
+                                                   std::vector<double>(1, size), std::vector<Vector2d>(1, p)));
+        defects[DEFECT_TYPE_RECTANGLE].push_back(Defect(DEFECT_TYPE_RECTANGLE, DEFECT_CLASS_PATTERN, 0, two,
+                                                        std::vector<Vector2d>(1, p)));
+        defects[DEFECT_TYPE_CHAIN].push_back(Defect(DEFECT_TYPE_CHAIN, DEFECT_CLASS_AXON, 0,
+                                                    std::vector<double>(1, size), chain));
+        defects[DEFECT_TYPE_PIXEL].push_back(Defect(DEFECT_TYPE_PIXEL, DEFECT_CLASS_PATTERN, 0, two,
+                                                    std::vector<Vector2d>(1, p)));
+        defects[DEFECT_TYPE_SEGMENT].push_back(Defect(DEFECT_TYPE_SEGMENT, DEFECT_CLASS_AXON, 0,
+                                                      std::vector<double>(1, 4*d.norm()), segment));
+    }
+    for(int a = 0; a < PROFILE_DEFECT_TYPES; a++)
+    {
+        for(int b = 0; b < PROFILE_DEFECT_TYPES; b++)
+        {
+            start = Profiler::wallTime();
+            for(int i = 0; i < BENCHMARK_INTERSECTIONS; i++)
+                hits += defects[a][i%BENCHMARK_DEFECTS].intersect(defects[b][(i*7+3)%BENCHMARK_DEFECTS]);
+            addResult(std::string("micro/intersect_")+DEFECT_NAMES[a]+"_"+DEFECT_NAMES[b], BENCHMARK_INTERSECTIONS,
+                      Profiler::wallTime()-start);
+        }
+    }
+    gsl_rng_free(rng);
+}
+
+// growAxon and addConnections for every neuron of a chamber built like
+// the pipeline does
+void Benchmark::benchmarkChamber(std::string patternFile, int neurons)
+{
+    neuron::generationParameters p = patternParameters(params, patternFile, neurons);
+    Chamber chamber(p.chamber);
+    gsl_rng* rng;
+    double start;
+
+    if(!chamber.isValid())
+    {
+        std::cout << "Warning! Missing pattern " << patternFile << "\n";
+        return;
+    }
+    rng = gsl_rng_alloc(gsl_rng_taus2);
+    gsl_rng_set(rng, 1);
+    chamber.setCultureParameters(p.culture);
+    chamber.setNeuronParameters(p.soma, p.dtree, p.axon);
+    chamber.setRNG(rng);
+    chamber.assignLattice();
+    chamber.assignPatternDefects();
+    chamber.insertNeurons(neurons);
+
+    start = Profiler::wallTime();
+    for(std::vector<Neuron>::iterator i = chamber.neuron.begin(); i != chamber.neuron.end(); i++)
+        i->growAxon();
+    addResult("micro/neuron_grow_axon", chamber.neuron.size(), Profiler::wallTime()-start);
+
+    chamber.growDendrites();
+    start = Profiler::wallTime();
+    for(std::vector<Neuron>::iterator i = chamber.neuron.begin(); i != chamber.neuron.end(); i++)
+        chamber.addConnections(*i);
+    addResult("micro/chamber_add_connections", chamber.neuron.size(), Profiler::wallTime()-start);
+    gsl_rng_free(rng);
+}
+
+// Whole pipeline on every bundled pattern found in patternDir. Densities
+// are in neurons per mm2 of the nominal culture area (width x height, or
+// width x width when the height comes from the image)
+void Benchmark::runMacro(std::string patternDir, const std::vector<double>& densities)
+{
+    double width = params.chamber.width, height = params.chamber.height > 0 ? params.chamber.height : width;
+    struct stat info;
+
+    for(int k = 0; k < MACRO_PATTERN_COUNT; k++)
+    {
+        std::string patternFile = patternDir+"/"+MACRO_PATTERNS[k]+".png";
+        if(stat(patternFile.c_str(), &info) != 0)
+        {
+            std::cout << "Warning! Missing pattern " << patternFile << "\n";
+            continue;
+        }
+        for(std::vector<double>::const_iterator d = densities.begin(); d != densities.end(); d++)
+        {
+            int neurons = int(*d*width*height);
+            std::stringstream name;
+            name << "macro/" << MACRO_PATTERNS[k] << "/" << *d;
+            for(int r = 0; r < repeats; r++)
+            {
+                double start = Profiler::wallTime();
+                GeneratedNetwork network;
+                if(!neuron::generate(patternParameters(params, patternFile, neurons), network))
+                    break;
+                addResult(name.str(), network.getNeuronCount(), Profiler::wallTime()-start);
+            }
+        }
+    }
+}
+
+void Benchmark::print()
+{
+    std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(12) << "operations"
+              << std::setw(14) << "seconds" << std::setw(16) << "ns/operation" << "\n";
+    for(std::vector<result>::iterator i = results.begin(); i != results.end(); i++)
+        std::cout << std::left << std::setw(44) << i->name << std::right << std::setw(12) << i->operations
+                  << std::setw(14) << i->seconds << std::setw(16)
+                  << (i->operations > 0 ? 1e9*i->seconds/i->operations : 0.) << "\n";
+}
+
+bool Benchmark::save(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    savedFile.precision(10);
+    savedFile << "% Neurongen benchmarks, best of " << repeats << " runs\n";
+    savedFile << "% name operations seconds ns_per_operation\n";
+    for(std::vector<result>::iterator i = results.begin(); i != results.end(); i++)
+        savedFile << i->name << " " << i->operations << " " << i->seconds << " "
+                  << (i->operations > 0 ? 1e9*i->seconds/i->operations : 0.) << "\n";
+    savedFile.close();
+    return true;
+}
+
+// Compares the time per operation with a saved results file. Returns false
+// if any benchmark got slower by more than tolerance (relative)
+bool Benchmark::compare(std::string baselineFile, double tolerance)
+{
+    std::ifstream inputFile(baselineFile.c_str());
+    std::map<std::string, double> baseline;
+    std::string line, name;
+    int64_t operations;
+    double seconds, perOperation, ratio;
+    bool passed = true;
+
+    if (!inputFile.is_open())
+    {
+        std::cout << "There was an error opening file " << baselineFile << "\n";
+        return false;
+    }
+    while(std::getline(inputFile, line))
+    {
+        std::stringstream lineStream(line);
+        if(line.empty() || line[0] == '%')
+            continue;
+        if(lineStream >> name >> operations >> seconds >> perOperation)
+            baseline[name] = perOperation;
+    }
+
+    std::cout << std::left << std::setw(44) << "benchmark" << std::right << std::setw(14) << "baseline ns"
+              << std::setw(14) << "current ns" << std::setw(10) << "ratio" << "\n";
+    for(std::vector<result>::iterator i = results.begin(); i != results.end(); i++)
+    {
+        if(baseline.find(i->name) == baseline.end() || i->operations == 0)
+            continue;
+        perOperation = 1e9*i->seconds/i->operations;
+        ratio = baseline[i->name] > 0 ? perOperation/baseline[i->name] : 1.;
+        std::cout << std::left << std::setw(44) << i->name << std::right << std::setw(14) << baseline[i->name]
+                  << std::setw(14) << perOperation << std::setw(10) << ratio;
+        if(ratio > 1.+tolerance)
+        {
+            std::cout << "  REGRESSION";
+            passed = false;
+        }
+        else if(ratio < 1.-tolerance)
+            std::cout << "  improved";
+        std::cout << "\n";
+    }
+    return passed;
+}
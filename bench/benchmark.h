@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _BENCHMARK_H_
+#define _BENCHMARK_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "neuronnamespace.h"
+
+// Micro benchmarks of the hot paths (lattice, defect intersections, axon
+// growth and connection search) and macro benchmarks of the whole
+// pipeline. Every benchmark runs several times and keeps the best time.
+// Results are written as text, one benchmark per line, and can be
+// compared against a previous results file.
+class Benchmark
+{
+    public:
+        Benchmark(const neuron::generationParameters& base);
+        inline void setRepeats(int rep)
+            {repeats = rep > 0 ? rep : 1;}
+        void runMicro(std::string patternFile, int neurons);
+        void runMacro(std::string patternDir, const std::vector<double>& densities);
+        void print();
+        bool save(std::string fileName);
+        bool compare(std::string baselineFile, double tolerance);
+        static neuron::generationParameters patternParameters(const neuron::generationParameters& base,
+                                                              std::string patternFile, int neurons);
+
+    private:
+        typedef struct result
+        {
+            std::string name;
+            int64_t operations;
+            double seconds;
+        } result;
+        void addResult(std::string name, int64_t operations, double seconds);
+        void benchmarkLattice(int neurons);
+        void benchmarkIntersections();
+        void benchmarkChamber(std::string patternFile, int neurons);
+
+        neuron::generationParameters params;
+        int repeats;
+        std::vector<result> results;
+};
+
+#endif
+    // _BENCHMARK_H_
+
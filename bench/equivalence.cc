@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "equivalence.h"
+#include "neurongen.h"
+
+static const char* SAMPLE_NAMES[SAMPLE_COUNT] = {"soma_nearest", "axon_length", "axon_end_to_end",
+                                                  "dendrite_radius", "out_degree", "in_degree",
+                                                  "connection_distance"};
+
+Equivalence::Equivalence(const neuron::generationParameters& ref, const neuron::generationParameters& cand)
+{
+    reference = ref;
+    candidate = cand;
+    seeds = 20;
+    firstSeed = 1;
+    ksAlpha = 0.01;
+    adAlpha = 0.01;
+}
+
+// Distance from every soma to the closest one, through a grid with about
+// one soma per cell searched in growing rings
+void Equivalence::nearestNeighbors(const std::vector<double>& positions, std::vector<double>& distances)
+{
+    size_t n = positions.size()/2;
+    double minX, maxX, minY, maxY, cell, best, dx, dy;
+    int cols, rows, cx, cy;
+    std::vector<std::vector<int> > grid;
+
+    if(n < 2)
+        return;
+    minX = maxX = positions[0];
+    minY = maxY = positions[1];
+    for(size_t i = 1; i < n; i++)
+    {
+        minX = std::min(minX, positions[2*i]);
+        maxX = std::max(maxX, positions[2*i]);
+        minY = std::min(minY, positions[2*i+1]);
+        maxY = std::max(maxY, positions[2*i+1]);
+    }
+    cell = std::max(sqrt((maxX-minX)*(maxY-minY)/n), 1e-9);
+    cols = int((maxX-minX)/cell)+1;
+    rows = int((maxY-minY)/cell)+1;
+    grid.resize(size_t(cols)*rows);
+    for(size_t i = 0; i < n; i++)
+        grid[size_t(int((positions[2*i+1]-minY)/cell))*cols+int((positions[2*i]-minX)/cell)].push_back(int(i));
+
+    for(size_t i = 0; i < n; i++)
+    {
+        cx = int((positions[2*i]-minX)/cell);
+        cy = int((positions[2*i+1]-minY)/cell);
+        best = INFINITY;
+        // Cells of ring r are at least (r-1)*cell away
+        for(int r = 0; r <= std::max(cols, rows); r++)
+        {
+            if(best <= (r-1)*cell)
+                break;
+            for(int y = cy-r; y <= cy+r; y++)
+            {
+                if(y < 0 || y >= rows)
+                    continue;
+                for(int x = cx-r; x <= cx+r; x++)
+                {
+                    if(x < 0 || x >= cols || (std::abs(x-cx) != r && std::abs(y-cy) != r))
+                        continue;
+                    const std::vector<int>& bucket = grid[size_t(y)*cols+x];
+                    for(std::vector<int>::const_iterator j = bucket.begin(); j != bucket.end(); j++)
+                    {
+                        if(size_t(*j) == i)
+                            continue;
+                        dx = positions[2*(*j)]-positions[2*i];
+                        dy = positions[2*(*j)+1]-positions[2*i+1];
+                        best = std::min(best, sqrt(dx*dx+dy*dy));
+                    }
+                }
+            }
+        }
+        distances.push_back(best);
+    }
+}
+
+// Appends the observables of one network to samples[SAMPLE_COUNT]
+void Equivalence::collect(const GeneratedNetwork& network, std::vector<double>* samples)
+{
+    const std::vector<double>& positions = network.getPositions();
+    const std::vector<int64_t>& axonOffsets = network.getAxonOffsets();
+    const std::vector<double>& axonPoints = network.getAxonPoints();
+    const Adjacency& adjacency = network.getAdjacency();
+    Adjacency transposed = adjacency.transpose();
+    const std::vector<int64_t>& offsets = adjacency.getOffsets();
+    const std::vector<int32_t>& targets = adjacency.getTargets();
+    int n = network.getNeuronCount();
+    double dx, dy;
+
+    nearestNeighbors(positions, samples[SAMPLE_SOMA_NEAREST]);
+    samples[SAMPLE_AXON_LENGTH].insert(samples[SAMPLE_AXON_LENGTH].end(), network.getAxonLengths().begin(),
+                                       network.getAxonLengths().end());
+    samples[SAMPLE_DENDRITE_RADIUS].insert(samples[SAMPLE_DENDRITE_RADIUS].end(), network.getDendriteRadii().begin(),
+                                           network.getDendriteRadii().end());
+    for(int i = 0; i < n; i++)
+    {
+        // From the soma to the tip, as Neuron::getAxonEndToEndDistance (the
+        // axon points are the segment ends, without the soma)
+        if(axonOffsets[i+1] > axonOffsets[i])
+        {
+            dx = axonPoints[2*(axonOffsets[i+1]-1)]-positions[2*i];
+            dy = axonPoints[2*(axonOffsets[i+1]-1)+1]-positions[2*i+1];
+            samples[SAMPLE_AXON_END_TO_END].push_back(sqrt(dx*dx+dy*dy));
+        }
+        samples[SAMPLE_OUT_DEGREE].push_back(adjacency.getDegree(i));
+        samples[SAMPLE_IN_DEGREE].push_back(transposed.getDegree(i));
+        for(int64_t j = offsets[i]; j < offsets[i+1]; j++)
+        {
+            dx = positions[2*targets[j]]-positions[2*i];
+            dy = positions[2*targets[j]+1]-positions[2*i+1];
+            samples[SAMPLE_CONNECTION_DISTANCE].push_back(sqrt(dx*dx+dy*dy));
+        }
+    }
+}
+
+// Generates every seed with both configurations, the reference with a
+// single thread
+void Equivalence::run()
+{
+    std::vector<double> referenceSamples[SAMPLE_COUNT], candidateSamples[SAMPLE_COUNT];
+    GeneratedNetwork network;
+#ifdef _OPENMP
+    int threads = omp_get_max_threads();
+#endif
+
+    for(int s = firstSeed; s < firstSeed+seeds; s++)
+    {
+        std::cout << "Equivalence: seed " << s << "...\n";
+        reference.seed = s;
+        candidate.seed = s;
+#ifdef _OPENMP
+        omp_set_num_threads(1);
+#endif
+        if(neuron::generate(reference, network))
+            collect(network, referenceSamples);
+#ifdef _OPENMP
+        omp_set_num_threads(threads);
+#endif
+        if(neuron::generate(candidate, network))
+            collect(network, candidateSamples);
+    }
+
+    comparisons.clear();
+    for(int k = 0; k < SAMPLE_COUNT; k++)
+    {
+        comparison newComparison;
+        newComparison.referenceSize = referenceSamples[k].size();
+        newComparison.candidateSize = candidateSamples[k].size();
+        newComparison.ks = kolmogorovSmirnov(referenceSamples[k], candidateSamples[k], newComparison.ksP);
+        newComparison.ad = andersonDarling(referenceSamples[k], candidateSamples[k], newComparison.adP);
+        newComparison.passed = newComparison.ksP >= ksAlpha && newComparison.adP >= adAlpha;
+        comparisons.push_back(newComparison);
+    }
+}
+
+// Two sample KS distance and its asymptotic p-value (Stephens correction)
+double Equivalence::kolmogorovSmirnov(std::vector<double> a, std::vector<double> b, double& pValue)
+{
+    double d = 0, en, lambda, term, sum = 0, sign = 1, value;
+    size_t i = 0, j = 0;
+
+    pValue = 1;
+    if(a.empty() || b.empty())
+        return 0;
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    while(i < a.size() && j < b.size())
+    {
+        value = std::min(a[i], b[j]);
+        while(i < a.size() && a[i] == value)
+            i++;
+        while(j < b.size() && b[j] == value)
+            j++;
+        d = std::max(d, std::abs(double(i)/a.size()-double(j)/b.size()));
+    }
+
+    en = sqrt(double(a.size())*b.size()/(a.size()+b.size()));
+    lambda = (en+0.12+0.11/en)*d;
+    if(lambda < 0.2)
+        return d;
+    for(int k = 1; k <= 100; k++)
+    {
+        term = sign*2*exp(-2*k*k*lambda*lambda);
+        sum += term;
+        if(std::abs(term) < 1e-10*std::abs(sum))
+            break;
+        sign = -sign;
+    }
+    pValue = std::min(1., std::max(0., sum));
+    return d;
+}
+
+// Scholz and Stephens (1987) k-sample statistic for two samples, midrank
+// version so ties (degrees) are handled. The standardized statistic is
+// converted to a p-value by interpolating its tabulated critical values in
+// log(significance), the result is clipped to [0.001, 0.25]
+double Equivalence::andersonDarling(std::vector<double> a, std::vector<double> b, double& pValue)
+{
+    static const double SIGNIFICANCE[7] = {0.25, 0.1, 0.05, 0.025, 0.01, 0.005, 0.001};
+    static const double B0[7] = {0.675, 1.281, 1.645, 1.96, 2.326, 2.573, 3.085};
+    static const double B1[7] = {-0.245, 0.25, 0.678, 1.149, 1.822, 2.364, 3.615};
+    static const double B2[7] = {-0.105, -0.305, -0.362, -0.391, -0.396, -0.345, -0.154};
+    std::vector<double> pooled;
+    std::vector<double>* samples[2] = {&a, &b};
+    double N, h = 0, g = 0, H, coefA, coefB, coefC, coefD, sigma2, A2 = 0, T, critical[7];
+    double lj, Bj, Mij, fij;
+    size_t left, right;
+    int k = 2;
+
+    pValue = 1;
+    if(a.size() < 2 || b.size() < 2)
+        return 0;
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    pooled = a;
+    pooled.insert(pooled.end(), b.begin(), b.end());
+    std::sort(pooled.begin(), pooled.end());
+    N = double(pooled.size());
+    if(pooled.front() == pooled.back())
+        return 0;
+
+    for(left = 0; left < pooled.size(); left = right)
+    {
+        right = std::upper_bound(pooled.begin()+left, pooled.end(), pooled[left])-pooled.begin();
+        lj = double(right-left);
+        Bj = left+lj/2;
+        for(int i = 0; i < k; i++)
+        {
+            std::vector<double>& s = *samples[i];
+            size_t lo = std::lower_bound(s.begin(), s.end(), pooled[left])-s.begin();
+            size_t hi = std::upper_bound(s.begin(), s.end(), pooled[left])-s.begin();
+            fij = double(hi-lo);
+            Mij = hi-fij/2;
+            A2 += lj/N*(N*Mij-Bj*s.size())*(N*Mij-Bj*s.size())/(Bj*(N-Bj)-N*lj/4)/s.size();
+        }
+    }
+    A2 *= (N-1)/N;
+
+    // Variance of the statistic, g summed in O(N) through the harmonic numbers
+    H = 1./a.size()+1./b.size();
+    std::vector<double> harmonic(size_t(N), 0);
+    for(size_t i = 1; i < size_t(N); i++)
+        harmonic[i] = harmonic[i-1]+1./i;
+    h = harmonic[size_t(N)-1];
+    for(size_t i = 1; i+1 < size_t(N); i++)
+        g += (h-harmonic[i])/(N-i);
+    coefA = (4*g-6)*(k-1)+(10-6*g)*H;
+    coefB = (2*g-4)*k*k+8*h*k+(2*g-14*h-4)*H-8*h+4*g-6;
+    coefC = (6*h+2*g-2)*k*k+(4*h-4*g+6)*k+(2*h-6)*H+4*h;
+    coefD = (2*h+6)*k*k-4*h*k;
+    sigma2 = (coefA*N*N*N+coefB*N*N+coefC*N+coefD)/((N-1)*(N-2)*(N-3));
+    T = (A2-(k-1))/sqrt(sigma2);
+
+    for(int i = 0; i < 7; i++)
+        critical[i] = B0[i]+B1[i]/sqrt(double(k-1))+B2[i]/(k-1);
+    if(T <= critical[0])
+        pValue = SIGNIFICANCE[0];
+    else if(T >= critical[6])
+        pValue = SIGNIFICANCE[6];
+    else
+    {
+        for(int i = 0; i < 6; i++)
+        {
+            if(T <= critical[i+1])
+            {
+                double t = (T-critical[i])/(critical[i+1]-critical[i]);
+                pValue = exp(log(SIGNIFICANCE[i])+t*(log(SIGNIFICANCE[i+1])-log(SIGNIFICANCE[i])));
+                break;
+            }
+        }
+    }
+    return T;
+}
+
+bool Equivalence::passed()
+{
+    for(std::vector<comparison>::iterator i = comparisons.begin(); i != comparisons.end(); i++)
+    {
+        if(!i->passed)
+            return false;
+    }
+    return true;
+}
+
+void Equivalence::print()
+{
+    std::cout << std::left << std::setw(22) << "observable" << std::right << std::setw(12) << "reference"
+              << std::setw(12) << "candidate" << std::setw(10) << "KS" << std::setw(10) << "KS p"
+              << std::setw(10) << "AD" << std::setw(10) << "AD p" << "\n";
+    for(size_t k = 0; k < comparisons.size(); k++)
+    {
+        std::cout << std::left << std::setw(22) << SAMPLE_NAMES[k] << std::right << std::setw(12)
+                  << comparisons[k].referenceSize << std::setw(12) << comparisons[k].candidateSize
+                  << std::setw(10) << std::setprecision(4) << comparisons[k].ks << std::setw(10) << comparisons[k].ksP
+                  << std::setw(10) << comparisons[k].ad << std::setw(10) << comparisons[k].adP;
+        if(!comparisons[k].passed)
+            std::cout << "  FAILED";
+        std::cout << "\n";
+    }
+    std::cout << (passed() ? "Candidate is statistically equivalent to the reference\n" :
+                             "Candidate differs from the reference\n");
+}
+
+bool Equivalence::save(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    savedFile.precision(10);
+    savedFile << "% Neurongen equivalence test, seeds " << firstSeed << " to " << firstSeed+seeds-1
+              << ", KS alpha " << ksAlpha << ", AD alpha " << adAlpha << "\n";
+    savedFile << "% observable reference_size candidate_size ks ks_p ad ad_p passed\n";
+    for(size_t k = 0; k < comparisons.size(); k++)
+        savedFile << SAMPLE_NAMES[k] << " " << comparisons[k].referenceSize << " " << comparisons[k].candidateSize
+                  << " " << comparisons[k].ks << " " << comparisons[k].ksP << " " << comparisons[k].ad << " "
+                  << comparisons[k].adP << " " << comparisons[k].passed << "\n";
+    savedFile.close();
+    return true;
+}
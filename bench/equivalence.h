@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _EQUIVALENCE_H_
+#define _EQUIVALENCE_H_
+
+#include <string>
+#include <vector>
+#include "neuronnamespace.h"
+
+class GeneratedNetwork;
+
+enum equivalenceSample
+{
+    SAMPLE_SOMA_NEAREST,
+    SAMPLE_AXON_LENGTH,
+    SAMPLE_AXON_END_TO_END,
+    SAMPLE_DENDRITE_RADIUS,
+    SAMPLE_OUT_DEGREE,
+    SAMPLE_IN_DEGREE,
+    SAMPLE_CONNECTION_DISTANCE,
+    SAMPLE_COUNT
+};
+
+// Statistical regression test for code paths that change the random
+// stream. The reference configuration runs serially and the candidate
+// with the default number of threads over the same seeds, the pooled
+// distributions of every observable are compared with the two sample
+// Kolmogorov-Smirnov and Anderson-Darling tests. An observable fails
+// when either p-value is below its significance level.
+class Equivalence
+{
+    public:
+        Equivalence(const neuron::generationParameters& ref, const neuron::generationParameters& cand);
+        inline void setSeeds(int count, int first)
+            {seeds = count; firstSeed = first;}
+        inline void setSignificance(double ks, double ad)
+            {ksAlpha = ks; adAlpha = ad;}
+        void run();
+        bool passed();
+        void print();
+        bool save(std::string fileName);
+        static double kolmogorovSmirnov(std::vector<double> a, std::vector<double> b, double& pValue);
+        static double andersonDarling(std::vector<double> a, std::vector<double> b, double& pValue);
+
+    private:
+        typedef struct comparison
+        {
+            size_t referenceSize, candidateSize;
+            double ks, ksP, ad, adP;
+            bool passed;
+        } comparison;
+        static void collect(const GeneratedNetwork& network, std::vector<double>* samples);
+        static void nearestNeighbors(const std::vector<double>& positions, std::vector<double>& distances);
+
+        neuron::generationParameters reference, candidate;
+        int seeds, firstSeed;
+        double ksAlpha, adAlpha;
+        std::vector<comparison> comparisons;
+};
+
+#endif
+    // _EQUIVALENCE_H_
+
@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include "benchmark.h"
+#include "equivalence.h"
+#include "neurongen.h"
+#include "scaling.h"
+
+static void usage()
+{
+    std::cout << "Usage: neurongen-bench [options]\n"
+              << "  --config file       base parameters (default config.cfg)\n"
+              << "  --patterns dir      bundled patterns (default patterns)\n"
+              << "  --micro | --macro   run only one of the suites\n"
+              << "  --neurons n         neurons of the micro benchmarks (default 5000)\n"
+              << "  --densities a,b,c   neurons per mm2 of the macro benchmarks (default 100,300)\n"
+              << "  --repeats n         runs of every benchmark, the best is kept (default 3)\n"
+              << "  --output file       results file\n"
+              << "  --baseline file     compare with a previous results file\n"
+              << "  --tolerance x       allowed relative slowdown (default 0.1)\n"
+              << "  --scaling           scaling study instead of the benchmarks\n"
+              << "  --pattern file      pattern of the scaling study (default square_periodic.png)\n"
+              << "  --neuron-counts l   neurons of the scaling study, at the density of the first\n"
+              << "                      on the config culture (default 1000,10000,100000)\n"
+              << "  --size-scales l     culture side factors at fixed density (default 0.5,1,2)\n"
+              << "  --thread-counts l   OpenMP threads (default 1,2,4,8)\n"
+              << "  --threshold x       flag stages growing faster than neurons^(1+x) (default 0.15)\n"
+              << "  --equivalence file  compare the networks of this config with the serial --config ones\n"
+              << "  --seeds n           seeds of the equivalence test (default 20)\n"
+              << "  --first-seed n      first seed of the equivalence test (default 1)\n"
+              << "  --ks-alpha x        significance of the Kolmogorov-Smirnov test (default 0.01)\n"
+              << "  --ad-alpha x        significance of the Anderson-Darling test (default 0.01)\n";
+}
+
+static std::vector<double> parseList(std::string list)
+{
+    std::vector<double> values;
+    std::stringstream tmpStr(list);
+    std::string item;
+    while(std::getline(tmpStr, item, ','))
+        values.push_back(atof(item.c_str()));
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string configFile = "config.cfg", patternDir = "patterns", outputFile, baselineFile;
+    std::string patternFile, candidateFile;
+    bool micro = true, macro = true, scaling = false;
+    int neurons = 5000, repeats = 3, seeds = 20, firstSeed = 1;
+    double tolerance = 0.1, threshold = 0.15, ksAlpha = 0.01, adAlpha = 0.01;
+    std::vector<double> densities, neuronCounts, sizeScales, threadCounts;
+    neuron::generationParameters params;
+
+    densities.push_back(100);
+    densities.push_back(300);
+    neuronCounts = parseList("1000,10000,100000");
+    sizeScales = parseList("0.5,1,2");
+    threadCounts = parseList("1,2,4,8");
+    for(int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i+1 < argc;
+        if(arg == "--micro")
+            macro = false;
+        else if(arg == "--macro")
+            micro = false;
+        else if(arg == "--scaling")
+            scaling = true;
+        else if(arg == "--config" && hasValue)
+            configFile = argv[++i];
+        else if(arg == "--patterns" && hasValue)
+            patternDir = argv[++i];
+        else if(arg == "--neurons" && hasValue)
+            neurons = atoi(argv[++i]);
+        else if(arg == "--densities" && hasValue)
+            densities = parseList(argv[++i]);
+        else if(arg == "--repeats" && hasValue)
+            repeats = atoi(argv[++i]);
+        else if(arg == "--output" && hasValue)
+            outputFile = argv[++i];
+        else if(arg == "--baseline" && hasValue)
+            baselineFile = argv[++i];
+        else if(arg == "--tolerance" && hasValue)
+            tolerance = atof(argv[++i]);
+        else if(arg == "--pattern" && hasValue)
+            patternFile = argv[++i];
+        else if(arg == "--neuron-counts" && hasValue)
+            neuronCounts = parseList(argv[++i]);
+        else if(arg == "--size-scales" && hasValue)
+            sizeScales = parseList(argv[++i]);
+        else if(arg == "--thread-counts" && hasValue)
+            threadCounts = parseList(argv[++i]);
+        else if(arg == "--threshold" && hasValue)
+            threshold = atof(argv[++i]);
+        else if(arg == "--equivalence" && hasValue)
+            candidateFile = argv[++i];
+        else if(arg == "--seeds" && hasValue)
+            seeds = atoi(argv[++i]);
+        else if(arg == "--first-seed" && hasValue)
+            firstSeed = atoi(argv[++i]);
+        else if(arg == "--ks-alpha" && hasValue)
+            ksAlpha = atof(argv[++i]);
+        else if(arg == "--ad-alpha" && hasValue)
+            adAlpha = atof(argv[++i]);
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if(!neuron::loadParameters(configFile, params))
+        return 1;
+    if(patternFile.empty())
+        patternFile = patternDir+"/square_periodic.png";
+
+    if(!candidateFile.empty())
+    {
+        neuron::generationParameters candidateParams;
+        if(!neuron::loadParameters(candidateFile, candidateParams))
+            return 1;
+        Equivalence test(params, candidateParams);
+        test.setSeeds(seeds, firstSeed);
+        test.setSignificance(ksAlpha, adAlpha);
+        test.run();
+        test.print();
+        if(!outputFile.empty())
+            test.save(outputFile);
+        return test.passed() ? 0 : 2;
+    }
+
+    if(scaling)
+    {
+        // The density of every series and the threads runs are those of
+        // the smallest neuron count on the culture of the config
+        int baseNeurons = neuronCounts.empty() ? params.culture.neuronNumber : int(neuronCounts.front());
+        Scaling study(Benchmark::patternParameters(params, patternFile, baseNeurons));
+        study.setThreshold(threshold);
+        study.runNeurons(neuronCounts);
+        study.runSizes(sizeScales);
+        study.runThreads(threadCounts);
+        study.print();
+        if(!outputFile.empty())
+            study.save(outputFile);
+        return 0;
+    }
+
+    Benchmark benchmark(params);
+    benchmark.setRepeats(repeats);
+    if(micro)
+        benchmark.runMicro(patternFile, neurons);
+    if(macro)
+        benchmark.runMacro(patternDir, densities);
+    benchmark.print();
+    if(!outputFile.empty())
+        benchmark.save(outputFile);
+    if(!baselineFile.empty() && !benchmark.compare(baselineFile, tolerance))
+        return 2;
+    return 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "neurongen.h"
+#include "profiler.h"
+#include "scaling.h"
+
+// Stages end when the progress reaches the total, the latest report of
+// every stage is kept
+typedef struct stageClock
+{
+    double start;
+    double last[neuron::STAGE_COUNT];
+} stageClock;
+
+static void recordStage(int stage, int done, int total, void* data)
+{
+    stageClock* clock = static_cast<stageClock*>(data);
+    clock->last[stage] = Profiler::wallTime();
+}
+
+Scaling::Scaling(const neuron::generationParameters& base)
+{
+    params = base;
+    params.seed = 1;
+    threshold = 0.15;
+}
+
+// The generation runs in a forked child that sends back the measure
+// through a pipe. Its output is discarded
+bool Scaling::measure(const neuron::generationParameters& p, int threads, scalingMeasure& result)
+{
+    int channel[2], status;
+    pid_t child;
+
+    memset(&result, 0, sizeof(scalingMeasure));
+    result.neurons = p.culture.neuronNumber;
+    result.threads = threads;
+    result.width = p.chamber.width;
+    result.height = p.chamber.height;
+    result.failed = true;
+    if(pipe(channel) != 0)
+        return false;
+    std::cout.flush();
+    child = fork();
+    if(child < 0)
+    {
+        close(channel[0]);
+        close(channel[1]);
+        return false;
+    }
+    if(child == 0)
+    {
+        stageClock clock;
+        struct rusage usage;
+
+        close(channel[0]);
+        if(!freopen("/dev/null", "w", stdout))
+            _exit(1);
+#ifdef _OPENMP
+        if(threads > 0)
+            omp_set_num_threads(threads);
+        result.threads = omp_get_max_threads();
+#endif
+        clock.start = Profiler::wallTime();
+        for(int s = 0; s < neuron::STAGE_COUNT; s++)
+            clock.last[s] = clock.start;
+        GeneratedNetwork network;
+        if(!neuron::generate(p, network, recordStage, &clock))
+            _exit(1);
+        result.totalSeconds = Profiler::wallTime()-clock.start;
+        for(int s = neuron::STAGE_PATTERN; s < neuron::STAGE_COUNT; s++)
+            result.stageSeconds[s] = std::max(0., clock.last[s]-std::max(clock.start, clock.last[s-1]));
+        getrusage(RUSAGE_SELF, &usage);
+        result.peakRSS = usage.ru_maxrss;
+        result.neurons = network.getNeuronCount();
+        result.connections = network.getAdjacency().getEdgeCount();
+        result.failed = false;
+        if(write(channel[1], &result, sizeof(scalingMeasure)) != sizeof(scalingMeasure))
+            _exit(1);
+        close(channel[1]);
+        _exit(0);
+    }
+    close(channel[1]);
+    if(read(channel[0], &result, sizeof(scalingMeasure)) != sizeof(scalingMeasure))
+        result.failed = true;
+    close(channel[0]);
+    waitpid(child, &status, 0);
+    if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        result.failed = true;
+    return !result.failed;
+}
+
+// Neuron count at the density of the base parameters. Width and height
+// grow with the square root of the count, so every run has the same soma
+// area fraction and a large count does not jam the culture
+void Scaling::runNeurons(const std::vector<double>& counts)
+{
+    for(std::vector<double>::const_iterator i = counts.begin(); i != counts.end(); i++)
+    {
+        run newRun;
+        neuron::generationParameters p = params;
+        double scale = params.culture.neuronNumber > 0 ? sqrt(*i/params.culture.neuronNumber) : 1.;
+        p.chamber.width *= scale;
+        if(p.chamber.height > 0)
+            p.chamber.height *= scale;
+        p.culture.neuronNumber = int(*i);
+        std::cout << "Scaling: " << p.culture.neuronNumber << " neurons, size x" << scale << "...\n";
+        newRun.series = "neurons";
+        measure(p, 0, newRun.measure);
+        runs.push_back(newRun);
+    }
+}
+
+// Width and height times scale, neurons times scale^2
+void Scaling::runSizes(const std::vector<double>& scales)
+{
+    for(std::vector<double>::const_iterator i = scales.begin(); i != scales.end(); i++)
+    {
+        run newRun;
+        neuron::generationParameters p = params;
+        p.chamber.width *= *i;
+        if(p.chamber.height > 0)
+            p.chamber.height *= *i;
+        p.culture.neuronNumber = int(params.culture.neuronNumber*(*i)*(*i));
+        std::cout << "Scaling: size x" << *i << ", " << p.culture.neuronNumber << " neurons...\n";
+        newRun.series = "size";
+        measure(p, 0, newRun.measure);
+        runs.push_back(newRun);
+    }
+}
+
+void Scaling::runThreads(const std::vector<double>& threads)
+{
+    for(std::vector<double>::const_iterator i = threads.begin(); i != threads.end(); i++)
+    {
+        run newRun;
+        std::cout << "Scaling: " << int(*i) << " threads...\n";
+        newRun.series = "threads";
+        measure(params, int(*i), newRun.measure);
+        runs.push_back(newRun);
+    }
+}
+
+// Least squares slope of log(time) against log(neurons). Stage -1 is the
+// total time
+double Scaling::fitExponent(std::string series, int stage)
+{
+    double sx = 0, sy = 0, sxx = 0, sxy = 0, x, y, t;
+    int n = 0;
+
+    for(std::vector<run>::iterator i = runs.begin(); i != runs.end(); i++)
+    {
+        if(i->series != series || i->measure.failed || i->measure.neurons <= 0)
+            continue;
+        t = stage < 0 ? i->measure.totalSeconds : i->measure.stageSeconds[stage];
+        if(t <= 0)
+            continue;
+        x = log(double(i->measure.neurons));
+        y = log(t);
+        sx += x;
+        sy += y;
+        sxx += x*x;
+        sxy += x*y;
+        n++;
+    }
+    if(n < 2 || n*sxx-sx*sx <= 0)
+        return NAN;
+    return (n*sxy-sx*sy)/(n*sxx-sx*sx);
+}
+
+// Exponents of the neurons and size series and the speedup of the threads
+// series, every line starts with prefix
+void Scaling::summarize(std::ostream& out, std::string prefix)
+{
+    const char* series[] = {"neurons", "size"};
+    double reference[neuron::STAGE_COUNT+1], speedup;
+    int referenceThreads = 0;
+
+    out << prefix << "series stage exponent (time ~ neurons^exponent)\n";
+    for(int k = 0; k < 2; k++)
+    {
+        for(int s = neuron::STAGE_PATTERN; s <= neuron::STAGE_COUNT; s++)
+        {
+            int stage = s < neuron::STAGE_COUNT ? s : -1;
+            double exponent = fitExponent(series[k], stage);
+            if(std::isnan(exponent))
+                continue;
+            out << prefix << series[k] << " " << (stage < 0 ? "total" : neuron::STAGE_NAMES[stage]) << " " << exponent;
+            if(exponent > 1.+threshold)
+                out << " SUPERLINEAR";
+            out << "\n";
+        }
+    }
+
+    // Speedup and parallel efficiency against the first thread count
+    out << prefix << "threads stage speedup efficiency\n";
+    for(std::vector<run>::iterator i = runs.begin(); i != runs.end(); i++)
+    {
+        if(i->series != "threads" || i->measure.failed)
+            continue;
+        if(referenceThreads == 0)
+        {
+            for(int s = 0; s < neuron::STAGE_COUNT; s++)
+                reference[s] = i->measure.stageSeconds[s];
+            reference[neuron::STAGE_COUNT] = i->measure.totalSeconds;
+            referenceThreads = std::max(1, i->measure.threads);
+        }
+        for(int s = neuron::STAGE_PATTERN; s <= neuron::STAGE_COUNT; s++)
+        {
+            double t = s < neuron::STAGE_COUNT ? i->measure.stageSeconds[s] : i->measure.totalSeconds;
+            if(t <= 0)
+                continue;
+            speedup = reference[s]/t;
+            out << prefix << i->measure.threads << " " << (s < neuron::STAGE_COUNT ? neuron::STAGE_NAMES[s] : "total")
+                << " " << speedup << " " << speedup*referenceThreads/std::max(1, i->measure.threads) << "\n";
+        }
+    }
+}
+
+void Scaling::print()
+{
+    std::cout << std::left << std::setw(9) << "series" << std::right << std::setw(10) << "neurons" << std::setw(8)
+              << "threads" << std::setw(12) << "seconds" << std::setw(14) << "peak RSS kB" << std::setw(14)
+              << "connections" << "\n";
+    for(std::vector<run>::iterator i = runs.begin(); i != runs.end(); i++)
+    {
+        std::cout << std::left << std::setw(9) << i->series << std::right << std::setw(10) << i->measure.neurons
+                  << std::setw(8) << i->measure.threads;
+        if(i->measure.failed)
+            std::cout << "  failed\n";
+        else
+            std::cout << std::setw(12) << i->measure.totalSeconds << std::setw(14) << i->measure.peakRSS
+                      << std::setw(14) << i->measure.connections << "\n";
+    }
+    summarize(std::cout, "");
+}
+
+bool Scaling::save(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    savedFile.precision(10);
+    savedFile << "% Neurongen scaling runs, stage times in seconds\n";
+    savedFile << "% series neurons width height threads";
+    for(int s = neuron::STAGE_PATTERN; s < neuron::STAGE_COUNT; s++)
+        savedFile << " " << neuron::STAGE_NAMES[s];
+    savedFile << " total peak_rss_kb connections\n";
+    for(std::vector<run>::iterator i = runs.begin(); i != runs.end(); i++)
+    {
+        if(i->measure.failed)
+        {
+            savedFile << "% " << i->series << " " << i->measure.neurons << " failed\n";
+            continue;
+        }
+        savedFile << i->series << " " << i->measure.neurons << " " << i->measure.width << " " << i->measure.height
+                  << " " << i->measure.threads;
+        for(int s = neuron::STAGE_PATTERN; s < neuron::STAGE_COUNT; s++)
+            savedFile << " " << i->measure.stageSeconds[s];
+        savedFile << " " << i->measure.totalSeconds << " " << i->measure.peakRSS << " " << i->measure.connections << "\n";
+    }
+    summarize(savedFile, "% ");
+    savedFile.close();
+    return true;
+}
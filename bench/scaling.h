@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _SCALING_H_
+#define _SCALING_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "neuronnamespace.h"
+
+// Result of one generation, measured in a child process so the peak
+// memory belongs to that run only
+typedef struct scalingMeasure
+{
+    int neurons, threads;
+    double width, height;
+    double stageSeconds[neuron::STAGE_COUNT];
+    double totalSeconds;
+    long peakRSS;
+    int64_t connections;
+    bool failed;
+} scalingMeasure;
+
+// Scaling study of the whole pipeline: neuron count and culture size, both
+// at the density of the base parameters, and thread count. For the first
+// two series the time of every stage is fitted to a power of the neuron
+// count and the stages whose exponent exceeds 1+threshold are flagged.
+// The density is kept constant so a flag means the code scales badly, not
+// that the culture got crowded.
+class Scaling
+{
+    public:
+        Scaling(const neuron::generationParameters& base);
+        inline void setThreshold(double thr)
+            {threshold = thr;}
+        void runNeurons(const std::vector<double>& counts);
+        void runSizes(const std::vector<double>& scales);
+        void runThreads(const std::vector<double>& threads);
+        void print();
+        bool save(std::string fileName);
+
+    private:
+        typedef struct run
+        {
+            std::string series;
+            scalingMeasure measure;
+        } run;
+        bool measure(const neuron::generationParameters& p, int threads, scalingMeasure& result);
+        double fitExponent(std::string series, int stage);
+        void summarize(std::ostream& out, std::string prefix);
+
+        neuron::generationParameters params;
+        double threshold;
+        std::vector<run> runs;
+};
+
+#endif
+    // _SCALING_H_
+
@@ -0,0 +1,61 @@
+######################################################################
+# Network generation library (libneurongen.a). The public header is
+# src/neurongen.h
+######################################################################
+
+include(neurongen.pri)
+TEMPLATE = lib
+TARGET = neurongen
+CONFIG += staticlib
+# Input
+HEADERS += src/adjacency.h \
+           src/axonbatch.h \
+           src/chamber.h \
+           src/checkpoint.h \
+           src/generatednetwork.h \
+           src/heatmap.h \
+           src/network.h \
+           src/lattice.h \
+           src/defect.h \
+           src/dynamics.h \
+           src/neuron.h \
+           src/neurongen.h \
+           src/neuronnamespace.h \
+           src/nullmodel.h \
+           src/numpyio.h \
+           src/pattern.h \
+           src/percolation.h \
+           src/profiler.h \
+           src/progress.h \
+           src/quorum.h \
+           src/random.h \
+           src/server.h \
+           src/stagecache.h \
+           src/statistics.h \
+           src/surrogate.h \
+           src/sweep.h
+SOURCES += src/adjacency.cc \
+           src/axonbatch.cc \
+           src/chamber.cc \
+           src/checkpoint.cc \
+           src/generatednetwork.cc \
+           src/heatmap.cc \
+           src/network.cc \
+           src/lattice.cc \
+           src/defect.cc \
+           src/dynamics.cc \
+           src/neuron.cc \
+           src/neurongen.cc \
+           src/nullmodel.cc \
+           src/numpyio.cc \
+           src/pattern.cc \
+           src/percolation.cc \
+           src/profiler.cc \
+           src/progress.cc \
+           src/quorum.cc \
+           src/random.cc \
+           src/server.cc \
+           src/stagecache.cc \
+           src/statistics.cc \
+           src/surrogate.cc \
+           src/sweep.cc
@@ -0,0 +1,20 @@
+######################################################################
+# Benchmark suite, micro benchmarks of the hot paths and the whole
+# pipeline over the bundled patterns, a scaling study and a statistical
+# equivalence test
+######################################################################
+
+include(neurongen.pri)
+TEMPLATE = app
+TARGET = neurongen-bench
+INCLUDEPATH += bench
+LIBS = -L$$OUT_PWD -lneurongen $$LIBS
+PRE_TARGETDEPS += $$OUT_PWD/libneurongen.a
+# Input
+HEADERS += bench/benchmark.h \
+           bench/equivalence.h \
+           bench/scaling.h
+SOURCES += bench/benchmark.cc \
+           bench/equivalence.cc \
+           bench/main.cc \
+           bench/scaling.cc
@@ -0,0 +1,12 @@
+######################################################################
+# Command line tool, a thin wrapper around libneurongen
+######################################################################
+
+include(neurongen.pri)
+TEMPLATE = app
+TARGET = neurongen
+LIBS = -L$$OUT_PWD -lneurongen $$LIBS
+PRE_TARGETDEPS += $$OUT_PWD/libneurongen.a
+# Input
+HEADERS += src/main.h
+SOURCES += src/main.cc
@@ -0,0 +1,15 @@
+######################################################################
+# Settings shared by the library and the command line tool
+######################################################################
+
+DEPENDPATH += . src
+INCLUDEPATH += . src /opt/local/include/eigen3 /usr/local/include/eigen3 /usr/include/eigen3 /opt/local/include /opt/local/include/QtGui /opt/local/include/QtCore /usr/include/qt4 /usr/include/qt4/QtCore /usr/include/qt4/QtGui
+LIBS += -L/usr/local/lib -lgsl -lgslcblas -fopenmp -lconfig++ -lpthread
+#LIBS += -L/usr/local/lib -lgsl -lgslcblas -lconfig++
+QMAKE_CXXFLAGS += -fopenmp
+CONFIG = console qt
+# Hot path counters and stage timers, see network.output.profiler
+#DEFINES += NEURONGEN_PROFILE
+#CONFIG += debug
+#QMAKE_CXXFLAGS_DEBUG += -pg
+#QMAKE_LFLAGS_DEBUG += -pg
@@ -2,30 +2,13 @@
 # Automatically generated by qmake (2.01a) Tue Mar 16 10:37:56 2010
 ######################################################################
 
-TEMPLATE = app
-TARGET = 
-DEPENDPATH += . src
-INCLUDEPATH += . src /opt/local/include/eigen3 /usr/local/include/eigen3 /usr/include/eigen3 /opt/local/include /opt/local/include/QtGui /opt/local/include/QtCore /usr/include/qt4 /usr/include/qt4/QtCore /usr/include/qt4/QtGui
-#LIBS += -L/usr/local/lib -lgsl -lgslcblas -fopenmp -lconfig++
-LIBS += -L/usr/local/lib -lgsl -lgslcblas -lconfig++
-#QMAKE_CXXFLAGS += -fopenmp
-CONFIG = console qt
-#CONFIG += debug
-#QMAKE_CXXFLAGS_DEBUG += -pg
-#QMAKE_LFLAGS_DEBUG += -pg
-# Input
-HEADERS += src/chamber.h \
-           src/main.h \
-           src/network.h \
-           src/lattice.h \
-           src/defect.h \
-           src/neuron.h \
-           src/neuronnamespace.h \
-           src/pattern.h
-SOURCES += src/chamber.cc \
-           src/main.cc \
-           src/network.cc \
-           src/lattice.cc \
-           src/defect.cc \
-           src/neuron.cc \
-           src/pattern.cc
+# The generator is built as a static library (libneurongen.pro) that the
+# command line tool (neurongen-cli.pro) and the benchmarks
+# (neurongen-bench.pro) link against
+TEMPLATE = subdirs
+SUBDIRS = library cli bench
+library.file = libneurongen.pro
+cli.file = neurongen-cli.pro
+cli.depends = library
+bench.file = neurongen-bench.pro
+bench.depends = library
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Python bindings for libneurongen. The arrays returned by generate() are
+// read-only NumPy views of the buffers of a GeneratedNetwork. The network
+// is owned by a capsule that every array keeps as its base object, so it
+// is freed once the last array is released.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+#include <string>
+#include "neurongen.h"
+
+template <class T> static const void* bufferOf(const std::vector<T>& v)
+{
+    return v.empty() ? NULL : &v[0];
+}
+
+static void destroyNetwork(PyObject* capsule)
+{
+    delete static_cast<GeneratedNetwork*>(PyCapsule_GetPointer(capsule, "neurongen.GeneratedNetwork"));
+}
+
+// Wraps a buffer of the network without copying it
+static PyObject* borrowArray(PyObject* capsule, int nd, npy_intp* dims, int type, const void* data)
+{
+    PyObject* array = PyArray_SimpleNewFromData(nd, dims, type, const_cast<void*>(data));
+    if(!array)
+        return NULL;
+    PyArray_CLEARFLAGS(reinterpret_cast<PyArrayObject*>(array), NPY_ARRAY_WRITEABLE);
+    Py_INCREF(capsule);
+    if(PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(array), capsule) < 0)
+    {
+        Py_DECREF(array);
+        return NULL;
+    }
+    return array;
+}
+
+static bool addArray(PyObject* dict, const char* name, PyObject* array)
+{
+    if(!array)
+        return false;
+    PyDict_SetItemString(dict, name, array);
+    Py_DECREF(array);
+    return true;
+}
+
+// Only read and written with the GIL held. The exception of the callback
+// is kept here, it is raised on the thread that called generate
+typedef struct progressTarget
+{
+    PyObject* callback;
+    bool failed;
+    PyObject *type, *value, *traceback;
+} progressTarget;
+
+// Called without the GIL, from the progress reporter thread while a stage
+// runs and from the generating thread when it finishes. Takes the GIL
+// before touching the target
+static void reportProgress(int stage, int done, int total, void* data)
+{
+    progressTarget* target = static_cast<progressTarget*>(data);
+    PyGILState_STATE state;
+    PyObject* result;
+
+    state = PyGILState_Ensure();
+    if(target->failed)
+    {
+        PyGILState_Release(state);
+        return;
+    }
+    result = PyObject_CallFunction(target->callback, "sii", neuron::STAGE_NAMES[stage], done, total);
+    if(result)
+        Py_DECREF(result);
+    else
+    {
+        // Keep the exception and ignore the remaining reports
+        target->failed = true;
+        PyErr_Fetch(&target->type, &target->value, &target->traceback);
+    }
+    PyGILState_Release(state);
+}
+
+static PyObject* generate(PyObject* self, PyObject* args, PyObject* kwargs)
+{
+    static const char* keywords[] = {"config", "seed", "progress", NULL};
+    const char* configFile;
+    PyObject* callback = Py_None;
+    PyObject *capsule, *result;
+    int seed = -1;
+    bool loaded, built = false;
+    neuron::generationParameters params;
+    progressTarget target;
+    GeneratedNetwork* network;
+    npy_intp dims[2];
+
+    if(!PyArg_ParseTupleAndKeywords(args, kwargs, "s|iO", const_cast<char**>(keywords), &configFile, &seed, &callback))
+        return NULL;
+    if(callback != Py_None && !PyCallable_Check(callback))
+    {
+        PyErr_SetString(PyExc_TypeError, "progress must be callable");
+        return NULL;
+    }
+    target.callback = callback;
+    target.failed = false;
+    target.type = target.value = target.traceback = NULL;
+
+    network = new GeneratedNetwork();
+    Py_BEGIN_ALLOW_THREADS
+    loaded = neuron::loadParameters(configFile, params);
+    if(loaded)
+    {
+        if(seed >= 0)
+            params.seed = seed;
+        built = neuron::generate(params, *network, callback != Py_None ? reportProgress : NULL, &target);
+    }
+    Py_END_ALLOW_THREADS
+
+    // The library prints the details, the exceptions only say which step
+    // failed
+    if(!loaded || !built || target.failed)
+    {
+        delete network;
+        if(!loaded)
+            PyErr_Format(PyExc_ValueError, "%s can not be read, does not define a network to generate or misses "
+                         "a required setting", configFile);
+        else if(!built)
+            PyErr_Format(PyExc_IOError, "The pattern file of %s can not be loaded", configFile);
+        else
+            PyErr_Restore(target.type, target.value, target.traceback);
+        return NULL;
+    }
+    capsule = PyCapsule_New(network, "neurongen.GeneratedNetwork", destroyNetwork);
+    if(!capsule)
+    {
+        delete network;
+        return NULL;
+    }
+
+    const Adjacency& adjacency = network->getAdjacency();
+    result = PyDict_New();
+    dims[0] = network->getNeuronCount();
+    dims[1] = 2;
+    bool ok = addArray(result, "positions", borrowArray(capsule, 2, dims, NPY_DOUBLE, bufferOf(network->getPositions())))
+        && addArray(result, "soma_radii", borrowArray(capsule, 1, dims, NPY_DOUBLE, bufferOf(network->getSomaRadii())))
+        && addArray(result, "dendrite_radii", borrowArray(capsule, 1, dims, NPY_DOUBLE, bufferOf(network->getDendriteRadii())))
+        && addArray(result, "axon_lengths", borrowArray(capsule, 1, dims, NPY_DOUBLE, bufferOf(network->getAxonLengths())))
+        && addArray(result, "cux", borrowArray(capsule, 1, dims, NPY_BOOL, bufferOf(network->getCUXactive())));
+    dims[0] = network->getAxonOffsets().size();
+    ok = ok && addArray(result, "axon_offsets", borrowArray(capsule, 1, dims, NPY_INT64, bufferOf(network->getAxonOffsets())));
+    dims[0] = network->getAxonPoints().size()/2;
+    ok = ok && addArray(result, "axon_points", borrowArray(capsule, 2, dims, NPY_DOUBLE, bufferOf(network->getAxonPoints())));
+    dims[0] = adjacency.getOffsets().size();
+    ok = ok && addArray(result, "csr_indptr", borrowArray(capsule, 1, dims, NPY_INT64, bufferOf(adjacency.getOffsets())));
+    dims[0] = adjacency.getTargets().size();
+    ok = ok && addArray(result, "csr_indices", borrowArray(capsule, 1, dims, NPY_INT32, bufferOf(adjacency.getTargets())));
+    Py_DECREF(capsule);
+    if(!ok)
+    {
+        Py_DECREF(result);
+        return NULL;
+    }
+    PyObject* seedObject = PyLong_FromLong(network->getSeed());
+    PyDict_SetItemString(result, "seed", seedObject);
+    Py_XDECREF(seedObject);
+    return result;
+}
+
+static PyMethodDef methods[] =
+{
+    {"generate", reinterpret_cast<PyCFunction>(generate), METH_VARARGS | METH_KEYWORDS,
+     "generate(config, seed=-1, progress=None)\n\n"
+     "Generates the network described by the config file and returns a dict of\n"
+     "read-only arrays: positions, soma_radii, dendrite_radii, axon_lengths, cux,\n"
+     "axon_offsets, axon_points, csr_indptr and csr_indices, plus the seed used.\n"
+     "The arrays share the memory of the generated network. progress is called as\n"
+     "progress(stage, done, total). The GIL is released while generating.\n"
+     "Raises ValueError if the config can not be used and IOError if the pattern\n"
+     "file can not be loaded."},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef module =
+{
+    PyModuleDef_HEAD_INIT, "neurongen", "Neuronal culture network generator", -1, methods
+};
+
+PyMODINIT_FUNC PyInit_neurongen()
+{
+    import_array();
+    return PyModule_Create(&module);
+}
@@ -0,0 +1,28 @@
+# Builds the neurongen Python module against libneurongen.a
+#
+#     qmake && make            (in the top folder, builds libneurongen.a)
+#     cd python && python setup.py build_ext --inplace
+#
+# NEURONGEN_BUILD points to the folder holding libneurongen.a if it was
+# built somewhere else
+
+import os
+import numpy
+from setuptools import setup, Extension
+
+here = os.path.dirname(os.path.abspath(__file__))
+root = os.path.dirname(here)
+build = os.environ.get("NEURONGEN_BUILD", root)
+
+module = Extension(
+    "neurongen",
+    sources=[os.path.join(here, "neurongenmodule.cc")],
+    include_dirs=[os.path.join(root, "src"), numpy.get_include(),
+                  "/usr/include/eigen3", "/usr/local/include/eigen3", "/opt/local/include/eigen3",
+                  "/usr/include/qt4", "/usr/include/qt4/QtCore", "/usr/include/qt4/QtGui"],
+    extra_objects=[os.path.join(build, "libneurongen.a")],
+    libraries=["gsl", "gslcblas", "config++", "QtGui", "QtCore", "gomp"],
+    extra_compile_args=["-std=c++11", "-fopenmp"],
+)
+
+setup(name="neurongen", version="0.01", ext_modules=[module])
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include "neuron.h"
+#include "adjacency.h"
+
+Adjacency::Adjacency()
+{
+    offsets.assign(1, 0);
+}
+
+Adjacency::Adjacency(std::vector<Neuron>& neuron)
+{
+    std::vector<Neuron*> connections;
+    int64_t edges = 0;
+
+    offsets.reserve(neuron.size()+1);
+    offsets.push_back(0);
+    for(std::vector<Neuron>::iterator i = neuron.begin(); i != neuron.end(); i++)
+    {
+        edges += i->getOutputConnections().size();
+        offsets.push_back(edges);
+    }
+    targets.reserve(edges);
+    for(std::vector<Neuron>::iterator i = neuron.begin(); i != neuron.end(); i++)
+    {
+        connections = i->getOutputConnections();
+        for(std::vector<Neuron*>::iterator j = connections.begin(); j != connections.end(); j++)
+            targets.push_back((*j)->getIndex());
+    }
+}
+
+// Counting sort by source, keeps the relative order of each row's edges
+Adjacency::Adjacency(int nodes, const std::vector<int32_t>& sources, const std::vector<int32_t>& destinations)
+{
+    std::vector<int64_t> position;
+
+    offsets.assign(nodes+1, 0);
+    for(std::vector<int32_t>::const_iterator i = sources.begin(); i != sources.end(); i++)
+        offsets[*i+1]++;
+    for(int i = 0; i < nodes; i++)
+        offsets[i+1] += offsets[i];
+
+    position.assign(offsets.begin(), offsets.end()-1);
+    targets.resize(destinations.size());
+    for(size_t i = 0; i < sources.size(); i++)
+        targets[position[sources[i]]++] = destinations[i];
+}
+
+// Input connections as rows
+Adjacency Adjacency::transpose() const
+{
+    std::vector<int32_t> sources = getSources();
+    return Adjacency(getNodeCount(), targets, sources);
+}
+
+// Same graph with every row sorted, without repeated edges or self loops
+Adjacency Adjacency::simplify() const
+{
+    Adjacency simple;
+    int nodes = getNodeCount();
+    std::vector<int64_t> rowSize(nodes, 0);
+
+    simple.targets = targets;
+    #pragma omp parallel for schedule(dynamic, 256)
+    for(int i = 0; i < nodes; i++)
+    {
+        std::vector<int32_t>::iterator first = simple.targets.begin()+offsets[i];
+        std::vector<int32_t>::iterator last = simple.targets.begin()+offsets[i+1];
+        std::sort(first, last);
+        last = std::unique(first, last);
+        last = std::remove(first, last, int32_t(i));
+        rowSize[i] = last-first;
+    }
+
+    // Compact the rows in place, each one only moves backwards
+    simple.offsets.assign(nodes+1, 0);
+    for(int i = 0; i < nodes; i++)
+    {
+        simple.offsets[i+1] = simple.offsets[i]+rowSize[i];
+        std::copy(simple.targets.begin()+offsets[i], simple.targets.begin()+offsets[i]+rowSize[i],
+                  simple.targets.begin()+simple.offsets[i]);
+    }
+    simple.targets.resize(simple.offsets[nodes]);
+    return simple;
+}
+
+// Undirected version, i and j are neighbors if either projects onto the other
+Adjacency Adjacency::symmetrize() const
+{
+    std::vector<int32_t> sources = getSources();
+    std::vector<int32_t> destinations(targets);
+
+    sources.insert(sources.end(), targets.begin(), targets.end());
+    destinations.insert(destinations.end(), sources.begin(), sources.begin()+targets.size());
+    return Adjacency(getNodeCount(), sources, destinations).simplify();
+}
+
+// Row indices of the COO representation
+std::vector<int32_t> Adjacency::getSources() const
+{
+    std::vector<int32_t> sources;
+    sources.reserve(targets.size());
+    for(int i = 0; i < getNodeCount(); i++)
+        sources.insert(sources.end(), getDegree(i), i);
+    return sources;
+}
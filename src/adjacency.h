@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _ADJACENCY_H_
+#define _ADJACENCY_H_
+
+#include <vector>
+#include <stdint.h>
+#include "neuronnamespace.h"
+
+class Neuron;
+
+// Compressed sparse row view of the output connections. Row i holds the
+// targets of neuron i in the same order as Neuron::getOutputConnections,
+// so the edge order matches the one in the connections text file.
+class Adjacency
+{
+    public:
+        Adjacency();
+        Adjacency(std::vector<Neuron>& neuron);
+        Adjacency(int nodes, const std::vector<int32_t>& sources, const std::vector<int32_t>& destinations);
+        Adjacency transpose() const;
+        Adjacency simplify() const;
+        Adjacency symmetrize() const;
+        std::vector<int32_t> getSources() const;
+        inline int getNodeCount() const
+            {return int(offsets.size())-1;}
+        inline int64_t getEdgeCount() const
+            {return int64_t(targets.size());}
+        inline int getDegree(int node) const
+            {return int(offsets[node+1]-offsets[node]);}
+        inline const std::vector<int64_t>& getOffsets() const
+            {return offsets;}
+        inline const std::vector<int32_t>& getTargets() const
+            {return targets;}
+
+    private:
+        std::vector<int64_t> offsets;
+        std::vector<int32_t> targets;
+};
+
+#endif
+    // _ADJACENCY_H_
+
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include "chamber.h"
+#include "defect.h"
+#include "neuron.h"
+#include "pattern.h"
+#include "profiler.h"
+#include "progress.h"
+#include "random.h"
+#include "axonbatch.h"
+
+AxonBatch::AxonBatch(Chamber* cham, neuron::axonParameters param)
+{
+    chamber = cham;
+    axonParams = param;
+    lanes = 0;
+}
+
+// Segments of the axon of lane l, as in Neuron::growAxon. The length is
+// already drawn
+void AxonBatch::start(Neuron& target, int l)
+{
+    Vector2d position = target.getPosition();
+
+    segmentLength[l] = axonParams.segmentLength;
+    segmentCount[l] = axonParams.segmentCount;
+    if(axonParams.segmentType == neuron::AXON_STYPE_FIXEDNUMBER)
+        segmentLength[l] = axonLength[l]/segmentCount[l];
+    else
+    {
+        segmentCount[l] = ceil(axonLength[l]/segmentLength[l]);
+        if(segmentCount[l] <= 1)
+        {
+            axonLength[l] += segmentLength[l];
+            segmentCount[l]++;
+        }
+    }
+    tipX[l] = position.x();
+    tipY[l] = position.y();
+    headingX[l] = 1.;
+    headingY[l] = 0.;
+    segments[l].clear();
+    segments[l].reserve(segmentCount[l]);
+}
+
+// Heading of the first segment, turn of the others
+double AxonBatch::drawTurn(int i, int trial, gsl_rng* rng)
+{
+    if(i == 0)
+        return Random::flat(rng, 0., 2.*M_PI);
+    if(axonParams.segmentAngleDistribution == neuron::DISTRIBUTION_UNIFORM)
+        return axonParams.meanSegmentAngle+Random::flat(rng, -axonParams.stdSegmentAngle,
+               axonParams.stdSegmentAngle)*trial;
+    return axonParams.meanSegmentAngle+Random::gaussian(rng, axonParams.stdSegmentAngle*trial);
+}
+
+// Exact test of the proposal of lane l, skipped when no pattern pixel is
+// within reach
+bool AxonBatch::collides(int l)
+{
+    std::vector<Vector2d> points;
+
+    if(clearance[l] > reach[l])
+        return false;
+    points.push_back(Vector2d(tipX[l], tipY[l]));
+    points.push_back(Vector2d(tipX[l]+proposalX[l]*reach[l], tipY[l]+proposalY[l]*reach[l]));
+    return chamber->checkIntersections(Defect(DEFECT_TYPE_SEGMENT, DEFECT_CLASS_AXON, 0,
+                                              std::vector<double>(1, segmentLength[l]), points));
+}
+
+// Retry loop of Neuron::growAxon for segment i of lane l, entered with the
+// outcome of the first proposal
+void AxonBatch::resolve(int l, int i, bool collision, gsl_rng* rng)
+{
+    int trial = 1, retry = 0;
+    double angle;
+    Vector2d end;
+
+    while(true)
+    {
+        end = Vector2d(tipX[l]+proposalX[l]*reach[l], tipY[l]+proposalY[l]*reach[l]);
+        if(collision && (axonParams.stdSegmentAngle*trial < axonParams.maxStdSegmentAngle))
+        {
+            retry++;
+            chamber->getProgress()->retry();
+            chamber->countHeatmap(HEATMAP_AXON_RETRIES, end);
+            PROFILE_COUNT(PROFILE_AXON_RETRIES);
+            if(retry >= axonParams.maxRetries)
+            {
+                retry = 0;
+                trial++;
+                PROFILE_COUNT(PROFILE_AXON_TRIALS);
+            }
+        }
+        else
+        {
+            if(axonParams.stdSegmentAngle*trial > axonParams.maxStdSegmentAngle)
+            {
+                std::cout << "Axon limit reached\n";
+                chamber->countHeatmap(HEATMAP_AXON_LIMITS, end);
+                PROFILE_COUNT(PROFILE_AXON_LIMIT);
+            }
+            return;
+        }
+        angle = drawTurn(i, trial, rng);
+        proposalX[l] = cos(angle)*headingX[l]-sin(angle)*headingY[l];
+        proposalY[l] = sin(angle)*headingX[l]+cos(angle)*headingY[l];
+        collision = collides(l);
+    }
+}
+
+// Grows the axons of neurons[0, count). Steered and analytic growth have
+// no lockstep form, their neurons grow one by one from the same stream
+void AxonBatch::grow(Neuron* neurons, int count, gsl_rng* rng)
+{
+    Pattern* pattern = chamber->getPattern();
+    bool field = pattern && pattern->hasDistanceField();
+    bool limited = axonParams.stdSegmentAngle > axonParams.maxStdSegmentAngle;
+    int steps = 0;
+
+    if(axonParams.growthMode != neuron::AXON_GROWTH_RETRY)
+    {
+        for(int l = 0; l < count; l++)
+        {
+            gsl_rng* parent = neurons[l].getRNG();
+            neurons[l].setRNG(rng);
+            neurons[l].growAxon();
+            neurons[l].setRNG(parent);
+        }
+        return;
+    }
+
+    lanes = std::min(count, AXON_BATCH_MAX);
+    Random::fillRayleigh(rng, axonLength, lanes, axonParams.stdLength);
+    for(int l = 0; l < lanes; l++)
+    {
+        start(neurons[l], l);
+        steps = std::max(steps, segmentCount[l]);
+    }
+
+    for(int i = 0; i < steps; i++)
+    {
+        // Draws in lane order, lanes that already finished take none
+        if(i > 0 && axonParams.segmentAngleDistribution != neuron::DISTRIBUTION_UNIFORM)
+        {
+            int active = 0;
+            for(int l = 0; l < lanes; l++)
+            {
+                turn[l] = 0.;
+                if(i < segmentCount[l])
+                    index[active++] = l;
+            }
+            Random::fillGaussian(rng, draws, active, axonParams.stdSegmentAngle);
+            for(int k = 0; k < active; k++)
+                turn[index[k]] = axonParams.meanSegmentAngle+draws[k];
+        }
+        else
+        {
+            for(int l = 0; l < lanes; l++)
+                turn[l] = i < segmentCount[l] ? drawTurn(i, 1, rng) : 0.;
+        }
+
+        // Proposals of every lane, the last segment is shorter. The first
+        // heading is the turn of (1, 0)
+        #pragma omp simd
+        for(int l = 0; l < lanes; l++)
+        {
+            double c = cos(turn[l]), s = sin(turn[l]);
+            proposalX[l] = c*headingX[l]-s*headingY[l];
+            proposalY[l] = s*headingX[l]+c*headingY[l];
+            reach[l] = i == segmentCount[l]-1 ? fmod(axonLength[l], segmentLength[l]) : segmentLength[l];
+        }
+        if(field)
+            pattern->getClearances(tipX, tipY, lanes, clearance);
+        else
+        {
+            for(int l = 0; l < lanes; l++)
+                clearance[l] = -HUGE_VAL;
+        }
+
+        for(int l = 0; l < lanes; l++)
+        {
+            bool collision;
+            if(i >= segmentCount[l])
+                continue;
+            collision = collides(l);
+            if(collision || limited)
+                resolve(l, i, collision, rng);
+        }
+
+        #pragma omp simd
+        for(int l = 0; l < lanes; l++)
+        {
+            double active = i < segmentCount[l] ? 1. : 0.;
+            tipX[l] += active*proposalX[l]*reach[l];
+            tipY[l] += active*proposalY[l]*reach[l];
+            headingX[l] = active*proposalX[l]+(1.-active)*headingX[l];
+            headingY[l] = active*proposalY[l]+(1.-active)*headingY[l];
+        }
+        for(int l = 0; l < lanes; l++)
+        {
+            if(i < segmentCount[l])
+                segments[l].push_back(Vector2d(tipX[l], tipY[l]));
+        }
+    }
+
+    for(int l = 0; l < lanes; l++)
+        neurons[l].setAxon(axonLength[l], segments[l]);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _AXONBATCH_H_
+#define _AXONBATCH_H_
+
+#include <vector>
+#include <Eigen/Core>
+#include "gsl/gsl_rng.h"
+#include "neuronnamespace.h"
+
+#define AXON_BATCH_MAX 16
+
+using namespace Eigen;
+
+class Chamber;
+class Neuron;
+
+// Grows the axons of up to AXON_BATCH_MAX neurons in lockstep, one lane
+// per neuron. Tips and headings are kept as arrays, so the turns of all
+// the lanes are drawn together and the rotations and the clearance test
+// (distance field of the pattern) run over every lane at once. Only the
+// lanes whose segment can reach a pattern pixel take the defect test, and
+// only those that collide go through the retry loop of Neuron::growAxon.
+// The clearance is a lower bound of the distance to the pattern and its
+// periodic images, so the skipped tests are those that could not collide.
+// Axons only collide with the pattern, so the result follows the same
+// distribution as the scalar growth, but the draws come in another order
+class AxonBatch
+{
+    public:
+        AxonBatch(Chamber* cham, neuron::axonParameters param);
+        void grow(Neuron* neurons, int count, gsl_rng* rng);
+
+    private:
+        void start(Neuron& target, int l);
+        double drawTurn(int i, int trial, gsl_rng* rng);
+        bool collides(int l);
+        void resolve(int l, int i, bool collision, gsl_rng* rng);
+
+        Chamber* chamber;
+        neuron::axonParameters axonParams;
+        int lanes;
+        // Lane state, the heading is a unit vector
+        double tipX[AXON_BATCH_MAX], tipY[AXON_BATCH_MAX];
+        double headingX[AXON_BATCH_MAX], headingY[AXON_BATCH_MAX];
+        double turn[AXON_BATCH_MAX], draws[AXON_BATCH_MAX], reach[AXON_BATCH_MAX], clearance[AXON_BATCH_MAX];
+        double proposalX[AXON_BATCH_MAX], proposalY[AXON_BATCH_MAX];
+        double axonLength[AXON_BATCH_MAX], segmentLength[AXON_BATCH_MAX];
+        int segmentCount[AXON_BATCH_MAX], index[AXON_BATCH_MAX];
+        std::vector<Vector2d> segments[AXON_BATCH_MAX];
+};
+
+#endif
+    // _AXONBATCH_H_
+
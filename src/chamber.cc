@@ -14,13 +14,18 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
 #include <fstream>
 #include <vector>
 #include <list>
 #include <set>
+#include "axonbatch.h"
 #include "lattice.h"
 #include "neuron.h"
 #include "pattern.h"
+#include "profiler.h"
+#include "progress.h"
+#include "random.h"
 #include "defect.h"
 #include "chamber.h"
 
@@ -37,11 +42,68 @@ Chamber::Chamber(neuron::chamberParameters p)
     postInit();
 }
 
+Chamber::~Chamber()
+{
+    delete lattice;
+    delete progress;
+    delete heatmap;
+    if(!sharedResources)
+    {
+        delete pattern;
+        if(densityMapLookupTable)
+            gsl_ran_discrete_free(densityMapLookupTable);
+    }
+}
+
+// New chamber for another realization of the same culture. It reuses the
+// pattern, the lattice with the pattern defects (as the read-only base of
+// its own lattice) and the density map tables, which must already be
+// assigned and are never modified afterwards, so several realizations can
+// be generated concurrently
+Chamber* Chamber::createRealization()
+{
+    Chamber* realization = new Chamber();
+
+    realization->param = param;
+    realization->cultureParam = cultureParam;
+    realization->somaParam = somaParam;
+    realization->dtreeParam = dtreeParam;
+    realization->axonParam = axonParam;
+
+    realization->pattern = pattern;
+    realization->lattice = new Lattice(lattice);
+    realization->densityMap = densityMap;
+    realization->densityMapX = densityMapX;
+    realization->densityMapY = densityMapY;
+    realization->densityMapP = densityMapP;
+    realization->densityMapPointWidth = densityMapPointWidth;
+    realization->densityMapPointHeight = densityMapPointHeight;
+    realization->densityMapLookupTable = densityMapLookupTable;
+    realization->sharedResources = true;
+    realization->progress->copySettings(*progress);
+    realization->profileBinWidth = profileBinWidth;
+    realization->profileMaxDistance = profileMaxDistance;
+    return realization;
+}
+
 // Variable preinitialization
 void Chamber::init()
 {
     pattern = NULL;
     lattice = NULL;
+    rng = NULL;
+    densityMapLookupTable = NULL;
+    sharedResources = false;
+    progress = new Progress();
+    heatmap = NULL;
+    profileBinWidth = 0;
+    profileMaxDistance = 0;
+    profileValid = false;
+    somaGridCell = 0;
+    somaGridSide = 0;
+    somaGridWidth = 0;
+    somaGridHeight = 0;
+    somaGridNeurons = -1;
     displayList = false;
     activeZone = false;
     densityMap = false;
@@ -104,7 +166,12 @@ void Chamber::postInit()
         if(param.pattern == true)
         {
             pattern = new Pattern(param.width, param.height);
-            pattern->loadPatternFromFile(param.patternFile);
+            // Without its pattern the chamber is not valid
+            if(!pattern->loadPatternFromFile(param.patternFile))
+            {
+                delete pattern;
+                pattern = NULL;
+            }
         }
     }
 }
@@ -130,9 +197,9 @@ bool Chamber::insertNeurons(int num)
     Defect defneuron;
     std::vector<double> nsize;
     nsize.push_back(somaParam.radius);
-    int j = 0, idx;
+    int idx;
 
-    std::cout << "Placing Neuron... 0\n";
+    progress->start(neuron::STAGE_PLACEMENT, newNeurons);
     for(std::vector<Neuron>::iterator i=(neuron.begin()+tnumber); i != neuron.end(); i++)
     {
 //        nsize.at(0) = i->getSomaRadius()*gsl_ran_flat(rng, 0.75, 1.25);
@@ -143,34 +210,89 @@ bool Chamber::insertNeurons(int num)
         defneuron = getEmptySpot(defneuron);
         lattice->addDefect(defneuron);
         i->setPosition(defneuron.getPoints());
-
-    //        std::cout << j << "\n";
-        if(fmod(j+1, 1000.0) == 0.0)
-            std::cout << "Placing Neuron... " << j+1 << "\n";
-        j++;
+        progress->advance();
     }
+    progress->finish();
 
     return true;
 }
 
-bool Chamber::growAxons()
+// Inserts neurons at known positions (input files or snapshots) without
+// using the RNG, the soma defects go to the lattice in the same order
+bool Chamber::restoreNeurons(std::vector<Vector2d> positions)
 {
-    int j = 0;
-    for(std::vector<Neuron>::iterator i=neuron.begin(); i != neuron.end(); i++)
+    int tnumber = neuron.size();
+    Defect defneuron;
+    std::vector<double> nsize;
+    nsize.push_back(somaParam.radius);
+
+    totalNeurons += positions.size();
+    neuron.insert(neuron.end(), positions.size(), Neuron(somaParam, axonParam, dtreeParam, this));
+
+    for(std::vector<Neuron>::iterator i=(neuron.begin()+tnumber); i != neuron.end(); i++)
     {
-        i->growAxon();
+        i->setRNG(rng);
+        i->setIndex(i-neuron.begin());
+        defneuron = Defect(DEFECT_TYPE_DISK, DEFECT_CLASS_SOMA,
+                           neuron::COL_PATTERN & neuron::COL_BOUNDARIES & neuron::COL_SOMAS, nsize,
+                           std::vector<Vector2d>(1, positions.at(i-neuron.begin()-tnumber)), i-neuron.begin());
+        lattice->addDefect(defneuron);
+        i->setPosition(defneuron.getPoints());
+    }
+    return true;
+}
 
-        if(fmod(j+1, 1000.0) == 0.0)
-            std::cout << "Growing Axon... " << j+1 << "\n";
-        j++;
+bool Chamber::growAxons()
+{
+    if((axonParam.growthMode != neuron::AXON_GROWTH_RETRY || axonParam.batch > 0) && pattern)
+        pattern->buildDistanceField();
+    progress->start(neuron::STAGE_AXONS, neuron.size());
+    if(axonParam.batch > 0)
+        growAxonBatches();
+    else
+    {
+        for(std::vector<Neuron>::iterator i=neuron.begin(); i != neuron.end(); i++)
+        {
+            i->growAxon();
+            progress->advance();
+        }
     }
+    progress->finish();
     return true;
 }
 
+// Consecutive neurons grow their axons in batches of axonParam.batch
+// lanes. Every batch draws from its own stream (same engine as the
+// chamber RNG), derived from a single draw of the chamber RNG, so the
+// axons depend on the seed and the batch size
+void Chamber::growAxonBatches()
+{
+    int count = neuron.size(), lanes = axonParam.batch;
+    int batches = (count+lanes-1)/lanes;
+    unsigned long base = gsl_rng_get(rng);
+
+    #pragma omp parallel
+    {
+        gsl_rng* stream = gsl_rng_alloc(rng->type);
+        AxonBatch batch(this, axonParam);
+
+        #pragma omp for schedule(dynamic, 4)
+        for(int g = 0; g < batches; g++)
+        {
+            int size = std::min(lanes, count-g*lanes);
+            gsl_rng_set(stream, Random::streamSeed(base, g));
+            batch.grow(&neuron[g*lanes], size, stream);
+            progress->advance(size);
+        }
+        gsl_rng_free(stream);
+    }
+}
+
 bool Chamber::growDendrites()
 {
     int idx;
     Defect dend;
+    progress->start(neuron::STAGE_DENDRITES, neuron.size());
     for(std::vector<Neuron>::iterator i=neuron.begin(); i != neuron.end(); i++)
     {
         idx = i-neuron.begin();
@@ -178,6 +300,22 @@ bool Chamber::growDendrites()
         dend.setIndex(idx);
         i->setIndex(idx);
         lattice->addDefect(dend);
+        progress->advance();
+    }
+    progress->finish();
+    return true;
+}
+
+// Same as growDendrites for neurons whose dendritic radius is already set
+bool Chamber::restoreDendrites()
+{
+    Defect dend;
+    for(std::vector<Neuron>::iterator i=neuron.begin(); i != neuron.end(); i++)
+    {
+        i->setIndex(i-neuron.begin());
+        dend = i->getDendrites();
+        dend.setIndex(i-neuron.begin());
+        lattice->addDefect(dend);
     }
     return true;
 }
@@ -214,7 +352,7 @@ std::vector<Neuron*> Chamber::addConnections(Neuron& origin)
         bounds.clear();
         bounds.push_back(*i);
         bounds.push_back(*(i+1));
-        tmplist = lattice->getDefectsInRange(bounds);
+        tmplist = getDefectsInRange(bounds);
         // Extract unique dendrites from the defect list
         for(std::list<Defect>::iterator j = tmplist.begin(); j != tmplist.end(); j++)
             if(j->getClassType() == DEFECT_CLASS_DTREE)
@@ -238,35 +376,245 @@ std::vector<Neuron*> Chamber::addConnections(Neuron& origin)
     return outputConnections;
 }
 
+// The lattice is only read here, so the output connections of every
+// neuron are searched in parallel. The inputs are assigned afterwards in
+// neuron order, as in the serial version
 bool Chamber::growConnections()
 {
-    std::vector<Neuron*> outputConnections;
-    std::vector<std::vector<Neuron*> > inputConnections;
-    inputConnections.insert(inputConnections.end(), neuron.size(), std::vector<Neuron* >());
-
-    int j = 0;
-    for(std::vector<Neuron>::iterator i=neuron.begin(); i != neuron.end(); i++)
+    int bins = profileMaxDistance > 0 ? int(ceil(profileMaxDistance/profileBinWidth)) : 0;
+    int count = neuron.size();
+
+    progress->start(neuron::STAGE_CONNECTIONS, count);
+    if(bins > 0)
+        buildSomaGrid(profileMaxDistance);
+    profileCandidates.assign(bins, 0);
+    profileConnected.assign(bins, 0);
+    #pragma omp parallel
     {
-        outputConnections = addConnections(*i);
+        std::vector<int64_t> candidates(bins, 0), connected(bins, 0);
 
-        for(std::vector<Neuron*>::iterator k=outputConnections.begin(); k != outputConnections.end(); k++)
+        #pragma omp for schedule(dynamic, 64)
+        for(int i = 0; i < count; i++)
         {
-           
-//            inputConnections.push_back(std::vector<Neuron* >());
-//            (inputConnections.at(i-neuron.begin())).push_back(*k);
-            inputConnections.at((*k)->getIndex()).push_back(&(*i));
+            addConnections(neuron[i]);
+            if(bins > 0)
+                accumulateProfile(i, candidates, connected);
+            progress->advance();
+        }
+
+        // Per thread histograms are merged once
+        #pragma omp critical (connectionProfile)
+        for(int b = 0; b < bins; b++)
+        {
+            profileCandidates[b] += candidates[b];
+            profileConnected[b] += connected[b];
         }
-        if(fmod(j+1, 1000.0) == 0.0)
-            std::cout << "Creating Output Connection... " << j+1 << "\n";
-        j++;
     }
+    profileValid = bins > 0;
+
+    assignInputConnections();
+    progress->finish();
+    return true;
+}
+
+// Inputs follow from the outputs, in neuron order
+void Chamber::assignInputConnections()
+{
+    std::vector<Neuron*> outputConnections;
+    std::vector<std::vector<Neuron*> > inputConnections(neuron.size());
 
     std::cout << "Assigning Input Connections... " << "\n";
+    for(std::vector<Neuron>::iterator i=neuron.begin(); i != neuron.end(); i++)
+    {
+        outputConnections = i->getOutputConnections();
+        for(std::vector<Neuron*>::iterator k=outputConnections.begin(); k != outputConnections.end(); k++)
+            inputConnections.at((*k)->getIndex()).push_back(&(*i));
+    }
     for(std::vector<Neuron>::iterator i=neuron.begin(); i != neuron.end(); i++)
         i->setInputConnections(inputConnections.at(i-neuron.begin()));
+}
+
+// A zero maxDistance disables the profile
+void Chamber::setConnectionProfile(double binWidth, double maxDistance)
+{
+    profileBinWidth = binWidth;
+    profileMaxDistance = binWidth > 0 ? maxDistance : 0;
+    profileValid = false;
+}
+
+// Same profile as growConnections for already connected neurons (e.g.
+// restored from a checkpoint)
+bool Chamber::computeConnectionProfile()
+{
+    int bins = profileMaxDistance > 0 ? int(ceil(profileMaxDistance/profileBinWidth)) : 0;
+    int count = neuron.size();
+
+    if(bins == 0)
+        return false;
+    buildSomaGrid(profileMaxDistance);
+    profileCandidates.assign(bins, 0);
+    profileConnected.assign(bins, 0);
+    #pragma omp parallel
+    {
+        std::vector<int64_t> candidates(bins, 0), connected(bins, 0);
+
+        #pragma omp for schedule(dynamic, 64)
+        for(int i = 0; i < count; i++)
+            accumulateProfile(i, candidates, connected);
+
+        #pragma omp critical (connectionProfile)
+        for(int b = 0; b < bins; b++)
+        {
+            profileCandidates[b] += candidates[b];
+            profileConnected[b] += connected[b];
+        }
+    }
+    profileValid = true;
     return true;
 }
 
+// Adds the pairs starting at neuron index to the distance histograms
+void Chamber::accumulateProfile(int index, std::vector<int64_t>& candidates, std::vector<int64_t>& connected)
+{
+    Vector2d position = neuron[index].getPosition();
+    std::vector<int> somas = getSomasInRange(index, profileMaxDistance);
+    std::vector<Neuron*> outputConnections = neuron[index].getOutputConnections();
+    size_t bin;
+
+    for(std::vector<int>::iterator i = somas.begin(); i != somas.end(); i++)
+    {
+        bin = size_t((neuron[*i].getPosition()-position).norm()/profileBinWidth);
+        if(bin < candidates.size())
+            candidates[bin]++;
+    }
+    for(std::vector<Neuron*>::iterator i = outputConnections.begin(); i != outputConnections.end(); i++)
+    {
+        bin = size_t(((*i)->getPosition()-position).norm()/profileBinWidth);
+        if(bin < connected.size())
+            connected[bin]++;
+    }
+}
+
+// Buckets the somas in cells of the given side (the query distance keeps
+// every query within 3x3 cells). The cells are never smaller than the mean
+// spacing of the somas, so the grid stays about as large as the neuron
+// list. Kept if it was already built with that side for these neurons
+void Chamber::buildSomaGrid(double cell)
+{
+    Vector2d low, high, position;
+    int count = neuron.size();
+
+    if(count == somaGridNeurons && cell == somaGridCell)
+        return;
+    somaGrid.clear();
+    somaGridNeurons = count;
+    somaGridCell = cell;
+    if(count == 0)
+        return;
+    low = high = neuron[0].getPosition();
+    for(int i = 1; i < count; i++)
+    {
+        position = neuron[i].getPosition();
+        low = low.cwiseMin(position);
+        high = high.cwiseMax(position);
+    }
+    cell = std::max(cell, sqrt((high-low).prod()/count));
+    if(!(cell > 0))
+        cell = 1.;
+    somaGridOrigin = low;
+    somaGridWidth = int((high.x()-low.x())/cell)+1;
+    somaGridHeight = int((high.y()-low.y())/cell)+1;
+    somaGridSide = cell;
+    somaGrid.resize(size_t(somaGridWidth)*somaGridHeight);
+    for(int i = 0; i < count; i++)
+    {
+        position = neuron[i].getPosition()-low;
+        somaGrid[size_t(position.y()/cell)*somaGridWidth+int(position.x()/cell)].push_back(i);
+    }
+}
+
+// Indices of the other somas whose center is in the box of half side
+// distance around neuron index, sorted. They come from the soma grid, so
+// no pixel, image or dendrite of the lattice is copied. buildSomaGrid has
+// to be called first, the grid is only read here
+std::vector<int> Chamber::getSomasInRange(int index, double distance)
+{
+    Vector2d position = neuron[index].getPosition(), other;
+    std::vector<int> somas;
+    int xmin, xmax, ymin, ymax;
+
+    if(somaGridNeurons != int(neuron.size()) || somaGrid.empty())
+        return somas;
+    xmin = std::max(int(floor((position.x()-distance-somaGridOrigin.x())/somaGridSide)), 0);
+    xmax = std::min(int(floor((position.x()+distance-somaGridOrigin.x())/somaGridSide)), somaGridWidth-1);
+    ymin = std::max(int(floor((position.y()-distance-somaGridOrigin.y())/somaGridSide)), 0);
+    ymax = std::min(int(floor((position.y()+distance-somaGridOrigin.y())/somaGridSide)), somaGridHeight-1);
+    for(int y = ymin; y <= ymax; y++)
+    {
+        for(int x = xmin; x <= xmax; x++)
+        {
+            std::vector<int>& cell = somaGrid[size_t(y)*somaGridWidth+x];
+            for(std::vector<int>::iterator i = cell.begin(); i != cell.end(); i++)
+            {
+                other = neuron[*i].getPosition()-position;
+                if(*i != index && fabs(other.x()) <= distance && fabs(other.y()) <= distance)
+                    somas.push_back(*i);
+            }
+        }
+    }
+    std::sort(somas.begin(), somas.end());
+    return somas;
+}
+
+// True if the straight line between both points crosses no pattern pixel
+bool Chamber::lineOfSight(Vector2d from, Vector2d to)
+{
+    if(!pattern)
+        return true;
+    return pattern->lineOfSight(from, to);
+}
+
+// Heatmap on the pattern grid, cells of scale x scale pixels. Kept if it
+// already exists
+void Chamber::enableHeatmap(int scale)
+{
+    if(heatmap)
+        return;
+    if(!pattern)
+    {
+        std::cout << "Warning! The heatmap needs a pattern\n";
+        return;
+    }
+    heatmap = new Heatmap(pattern->getOrigin(), pattern->getUnitSize(), pattern->getSizeCount().x(),
+                          pattern->getSizeCount().y(), scale);
+}
+
+// Range query of the lattice, the candidates are counted on the heatmap at
+// the center of the bounds
+std::list<Defect> Chamber::getDefectsInRange(const std::vector<Vector2d>& bounds)
+{
+    std::list<Defect> dlist = lattice->getDefectsInRange(bounds);
+    Vector2d center(0, 0);
+
+    if(heatmap && !bounds.empty())
+    {
+        for(std::vector<Vector2d>::const_iterator i = bounds.begin(); i != bounds.end(); i++)
+            center += *i;
+        heatmap->count(HEATMAP_RANGE_CANDIDATES, center/double(bounds.size()), dlist.size());
+    }
+    return dlist;
+}
+
+void Chamber::setProgressCallback(neuron::progressCallback callback, void* data)
+{
+    progress->setCallback(callback, data);
+}
+
+void Chamber::setProgressOutput(bool quiet, double interval, std::ostream* stream, int id)
+{
+    progress->setOutput(quiet, interval, stream, id);
+}
+
 bool Chamber::assignDensityMap()
 {
     if(!param.densityMap)
@@ -332,6 +680,7 @@ bool Chamber::assignDensityMap()
     for(int i = 0; i < events; i++)
         eventProbabilities[i] = densityMapP.at(i);
     densityMapLookupTable = gsl_ran_discrete_preproc(events, eventProbabilities);
+    delete [] eventProbabilities;
     densityMap = true;
     param.type = neuron::CH_TYPE_CUSTOM_WITH_DENSITY_MAP;
 
@@ -359,16 +708,16 @@ Defect Chamber::getEmptySpot(Defect def)
                 tmpIndex = gsl_ran_discrete(rng, densityMapLookupTable);
                 tmpX = densityMapX.at(tmpIndex);
                 tmpY = densityMapY.at(tmpIndex);
-                tmpX += gsl_ran_flat(rng, 0., 1.)*densityMapPointWidth;
-                tmpY -= gsl_ran_flat(rng, 0., 1.)*densityMapPointHeight;
+                tmpX += Random::flat(rng, 0., 1.)*densityMapPointWidth;
+                tmpY -= Random::flat(rng, 0., 1.)*densityMapPointHeight;
 //                std::cout << tmpX << " " << densityMapX.at(tmpIndex) << "\n";
                 points.clear();
                 points.push_back(Vector2d(tmpX, tmpY));
                 break;
             case neuron::CH_TYPE_CUSTOM:
             default:
-                tmpX = gsl_ran_flat(rng, -0.5,0.5)*param.width;
-                tmpY = gsl_ran_flat(rng, -0.5,0.5)*param.height;
+                tmpX = Random::flat(rng, -0.5,0.5)*param.width;
+                tmpY = Random::flat(rng, -0.5,0.5)*param.height;
                 points.clear();
                 points.push_back(Vector2d(tmpX, tmpY));
                 break;
@@ -377,7 +726,7 @@ Defect Chamber::getEmptySpot(Defect def)
 //            std::cout << tmpX << " " << tmpY << "\n";
         def.setPoints(points);
   //          std::cout << "empty1.6\n";
-        std::list<Defect> dlist = lattice->getDefectsInRange(def.getDefectLimits());
+        std::list<Defect> dlist = getDefectsInRange(def.getDefectLimits());
 //        if(dlist.size() > 0)
 //            std::cout << "Defects: " << dlist.size() << "\n";
         for(std::list<Defect>::iterator i = dlist.begin(); i != dlist.end(); i++)
@@ -385,11 +734,15 @@ Defect Chamber::getEmptySpot(Defect def)
             if(def.intersect(*i) && (retries < maxretries))
             {
                 valid = false;
+                progress->retry();
+                countHeatmap(HEATMAP_PLACEMENT_REJECTS, points.at(0));
+                PROFILE_COUNT(PROFILE_PLACEMENT_RETRIES);
                 break;
             }
             else if(retries >= maxretries)
             {
                 std::cout << "Retry limit reached\n";
+                PROFILE_COUNT(PROFILE_PLACEMENT_LIMIT);
                 break;
             }
         }
@@ -399,7 +752,7 @@ Defect Chamber::getEmptySpot(Defect def)
 
 bool Chamber::checkIntersections(Defect def)
 {
-    std::list<Defect> dlist = lattice->getDefectsInRange(def.getDefectLimits());
+    std::list<Defect> dlist = getDefectsInRange(def.getDefectLimits());
     for(std::list<Defect>::iterator i = dlist.begin(); i != dlist.end(); i++)
         if(def.intersect(*i))
             return true;
@@ -410,8 +763,8 @@ bool Chamber::checkIntersections(Defect def)
 Vector2d Chamber::getEmptySpot()
 {
     double tmpX, tmpY;
-    tmpX = gsl_ran_flat(rng, -0.5,0.5)*(pattern->getSize()).x();
-    tmpY = gsl_ran_flat(rng, -0.5,0.5)*(pattern->getSize()).y();
+    tmpX = Random::flat(rng, -0.5,0.5)*(pattern->getSize()).x();
+    tmpY = Random::flat(rng, -0.5,0.5)*(pattern->getSize()).y();
 
     return Vector2d(tmpX, tmpY);
 }
@@ -17,8 +17,11 @@
 #ifndef _CHAMBER_H_
 #define _CHAMBER_H_
 
+#include <list>
 #include <vector>
+#include <stdint.h>
 #include <Eigen/Core>
+#include "heatmap.h"
 #include "neuron.h"
 #include "neuronnamespace.h"
 
@@ -30,12 +33,17 @@ using namespace Eigen;
 class Lattice;
 class Pattern;
 class Defect;
+class Progress;
 
 class Chamber
 {
     public:
         Chamber();
         Chamber(neuron::chamberParameters p);
+        ~Chamber();
+        Chamber* createRealization();
+        inline bool isValid()
+            {return !(param.type == neuron::CH_TYPE_CUSTOM && param.pattern) || pattern;}
         void draw();
         inline void setCultureParameters(neuron::cultureParameters cparam)
             {cultureParam = cparam;}
@@ -48,17 +56,52 @@ class Chamber
         bool assignPatternDefects();
         bool assignDensityMap();
         bool insertNeurons(int num = 0);
+        bool restoreNeurons(std::vector<Vector2d> positions);
+        bool restoreDendrites();
         bool growAxons();
         bool growDendrites();
         bool growConnections();
+        void setConnectionProfile(double binWidth, double maxDistance);
+        bool computeConnectionProfile();
+        inline bool hasConnectionProfile()
+            {return profileValid;}
+        inline double getProfileBinWidth()
+            {return profileBinWidth;}
+        inline const std::vector<int64_t>& getProfileCandidates()
+            {return profileCandidates;}
+        inline const std::vector<int64_t>& getProfileConnected()
+            {return profileConnected;}
+        void assignInputConnections();
+        void buildSomaGrid(double cell);
+        std::vector<int> getSomasInRange(int index, double distance);
+        bool lineOfSight(Vector2d from, Vector2d to);
         std::vector<Neuron*> addConnections(Neuron& origin);
         std::vector<Vector2d> growSingleAxon(Vector2d origin);
 
         void setActiveZone(Vector2d center, double radius);
         inline void setRNG(gsl_rng* rngp)
             {rng = rngp;}
+        void setProgressCallback(neuron::progressCallback callback, void* data);
+        void setProgressOutput(bool quiet, double interval, std::ostream* stream, int id);
+        inline Progress* getProgress()
+            {return progress;}
+        void enableHeatmap(int scale);
+        inline Pattern* getPattern()
+            {return pattern;}
+        inline Heatmap* getHeatmap()
+            {return heatmap;}
+        inline void countHeatmap(int counter, const Vector2d& position, uint64_t amount = 1)
+            {if(heatmap) heatmap->count(counter, position, amount);}
         inline neuron::dtreeParameters getDtreeParameters()
             {return dtreeParam;}
+        inline neuron::chamberParameters getChamberParameters()
+            {return param;}
+        inline neuron::somaParameters getSomaParameters()
+            {return somaParam;}
+        inline neuron::axonParameters getAxonParameters()
+            {return axonParam;}
+        inline neuron::cultureParameters getCultureParameters()
+            {return cultureParam;}
         Vector2d getEmptySpot();
         Defect getEmptySpot(Defect def);
         bool checkIntersections(Defect def);
@@ -68,8 +111,13 @@ class Chamber
         void init();
         void postInit();
         void normalizeUnits();
+        void growAxonBatches();
+        std::list<Defect> getDefectsInRange(const std::vector<Vector2d>& bounds);
+        void accumulateProfile(int index, std::vector<int64_t>& candidates, std::vector<int64_t>& connected);
 
         bool displayList, activeZone, densityMap;
+        // Pattern, base lattice and density map belong to another chamber
+        bool sharedResources;
         Vector2d activeZoneCenter;
         double activeZoneRadius;
 
@@ -87,6 +135,20 @@ class Chamber
         std::vector<double> densityMapX, densityMapY, densityMapP;
         double densityMapPointWidth, densityMapPointHeight;
         gsl_ran_discrete_t* densityMapLookupTable;
+        Progress* progress;
+        Heatmap* heatmap;
+        // Connection probability against soma distance (inactive if
+        // profileMaxDistance is 0)
+        double profileBinWidth, profileMaxDistance;
+        bool profileValid;
+        std::vector<int64_t> profileCandidates, profileConnected;
+        // Soma indices bucketed by position, cells of somaGridSide from
+        // somaGridOrigin (row major, somaGridWidth cells per row). Built
+        // for somaGridNeurons neurons and a requested side of somaGridCell
+        std::vector<std::vector<int> > somaGrid;
+        Vector2d somaGridOrigin;
+        double somaGridCell, somaGridSide;
+        int somaGridWidth, somaGridHeight, somaGridNeurons;
 };
 
 #endif
@@ -0,0 +1,278 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <stdio.h> // for rename
+#include <string.h>
+#include "chamber.h"
+#include "neuron.h"
+#include "checkpoint.h"
+
+#define CHECKPOINT_MAGIC "NGCK"
+#define CHECKPOINT_VERSION 1
+
+template <class T> static void writeValue(std::ofstream& file, T value)
+{
+    file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T> static void readValue(std::ifstream& file, T& value)
+{
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+}
+
+static void writeString(std::ofstream& file, const std::string& str)
+{
+    writeValue<uint32_t>(file, str.size());
+    file.write(str.data(), str.size());
+}
+
+static void readString(std::ifstream& file, std::string& str)
+{
+    uint32_t length = 0;
+    readValue(file, length);
+    str.assign(length, '\0');
+    if(length > 0)
+        file.read(&str[0], length);
+}
+
+Checkpoint::Checkpoint()
+{
+    stage = neuron::STAGE_NONE;
+    seed = 0;
+    width = height = somaRadius = 0.;
+}
+
+void Checkpoint::capture(int stg, int sd, gsl_rng* rng, Chamber* chamber)
+{
+    neuronState state;
+    std::vector<Neuron*> connections;
+    neuron::chamberParameters cparams = chamber->getChamberParameters();
+
+    stage = stg;
+    seed = sd;
+    rngName = gsl_rng_name(rng);
+    rngState.assign(static_cast<char*>(gsl_rng_state(rng)),
+                    static_cast<char*>(gsl_rng_state(rng))+gsl_rng_size(rng));
+    patternFile = cparams.patternFile;
+    width = cparams.width;
+    height = cparams.height;
+    somaRadius = chamber->getSomaParameters().radius;
+
+    neurons.clear();
+    if(stage < neuron::STAGE_PLACEMENT)
+        return;
+    neurons.reserve(chamber->neuron.size());
+    for(std::vector<Neuron>::iterator i = chamber->neuron.begin(); i != chamber->neuron.end(); i++)
+    {
+        state.position = i->getPosition();
+        state.somaRadius = i->getSomaRadius();
+        state.axonLength = stage >= neuron::STAGE_AXONS ? i->getAxonLength() : 0.;
+        state.dtreeRadius = stage >= neuron::STAGE_DENDRITES ? i->getDtreeRadius() : 0.;
+        state.CUXactive = stage >= neuron::STAGE_DENDRITES ? i->getCUXactive() : false;
+        state.axonSegments.clear();
+        if(stage >= neuron::STAGE_AXONS)
+            state.axonSegments = i->getAxonSegments();
+        state.outputConnections.clear();
+        if(stage >= neuron::STAGE_CONNECTIONS)
+        {
+            connections = i->getOutputConnections();
+            for(std::vector<Neuron*>::iterator j = connections.begin(); j != connections.end(); j++)
+                state.outputConnections.push_back((*j)->getIndex());
+        }
+        neurons.push_back(state);
+    }
+}
+
+// The chamber must already have its lattice, pattern defects and density
+// map. Everything after that is replayed from the snapshot.
+bool Checkpoint::restore(Chamber* chamber, gsl_rng* rng)
+{
+    std::vector<Vector2d> positions;
+    std::vector<Neuron*> outputConnections;
+    std::vector<std::vector<Neuron*> > inputConnections;
+
+    if(rngName != gsl_rng_name(rng) || rngState.size() != gsl_rng_size(rng))
+    {
+        std::cout << "Error. The checkpoint RNG (" << rngName << ") does not match the current one\n";
+        return false;
+    }
+    memcpy(gsl_rng_state(rng), &rngState[0], rngState.size());
+
+    if(stage < neuron::STAGE_PLACEMENT)
+        return true;
+    for(std::vector<neuronState>::iterator i = neurons.begin(); i != neurons.end(); i++)
+        positions.push_back(i->position);
+    chamber->restoreNeurons(positions);
+
+    for(size_t i = 0; i < neurons.size(); i++)
+    {
+        chamber->neuron[i].setSomaRadius(neurons[i].somaRadius);
+        if(stage >= neuron::STAGE_AXONS)
+            chamber->neuron[i].setAxon(neurons[i].axonLength, neurons[i].axonSegments);
+        if(stage >= neuron::STAGE_DENDRITES)
+        {
+            chamber->neuron[i].setDtreeRadius(neurons[i].dtreeRadius);
+            chamber->neuron[i].setCUXactive(neurons[i].CUXactive);
+        }
+    }
+    if(stage >= neuron::STAGE_DENDRITES)
+        chamber->restoreDendrites();
+
+    if(stage >= neuron::STAGE_CONNECTIONS)
+    {
+        inputConnections.insert(inputConnections.end(), neurons.size(), std::vector<Neuron*>());
+        for(size_t i = 0; i < neurons.size(); i++)
+        {
+            outputConnections.clear();
+            for(std::vector<int32_t>::iterator j = neurons[i].outputConnections.begin();
+                j != neurons[i].outputConnections.end(); j++)
+            {
+                outputConnections.push_back(&(chamber->neuron.at(*j)));
+                inputConnections.at(*j).push_back(&(chamber->neuron[i]));
+            }
+            chamber->neuron[i].setOutputConnections(outputConnections);
+        }
+        for(size_t i = 0; i < neurons.size(); i++)
+            chamber->neuron[i].setInputConnections(inputConnections.at(i));
+    }
+    return true;
+}
+
+// Check that the snapshot was taken with the same lattice inputs
+bool Checkpoint::matches(Chamber* chamber)
+{
+    neuron::chamberParameters cparams = chamber->getChamberParameters();
+    return patternFile == cparams.patternFile && width == cparams.width && height == cparams.height
+           && somaRadius == chamber->getSomaParameters().radius;
+}
+
+// Written to a temporary file first so a crash never leaves a truncated snapshot
+bool Checkpoint::save(std::string fileName)
+{
+    std::string tmpName = fileName+".tmp";
+    std::ofstream savedFile(tmpName.c_str(), std::ios::out | std::ios::binary);
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << tmpName;
+        return false;
+    }
+
+    savedFile.write(CHECKPOINT_MAGIC, 4);
+    writeValue<uint32_t>(savedFile, CHECKPOINT_VERSION);
+    writeValue<int32_t>(savedFile, stage);
+    writeValue<int32_t>(savedFile, seed);
+    writeString(savedFile, rngName);
+    writeValue<uint64_t>(savedFile, rngState.size());
+    savedFile.write(&rngState[0], rngState.size());
+    writeString(savedFile, patternFile);
+    writeValue(savedFile, width);
+    writeValue(savedFile, height);
+    writeValue(savedFile, somaRadius);
+
+    writeValue<uint64_t>(savedFile, neurons.size());
+    for(std::vector<neuronState>::iterator i = neurons.begin(); i != neurons.end(); i++)
+    {
+        writeValue(savedFile, i->position.x());
+        writeValue(savedFile, i->position.y());
+        writeValue(savedFile, i->somaRadius);
+        writeValue(savedFile, i->axonLength);
+        writeValue(savedFile, i->dtreeRadius);
+        writeValue<uint8_t>(savedFile, i->CUXactive);
+        writeValue<uint32_t>(savedFile, i->axonSegments.size());
+        for(std::vector<Vector2d>::iterator j = i->axonSegments.begin(); j != i->axonSegments.end(); j++)
+        {
+            writeValue(savedFile, j->x());
+            writeValue(savedFile, j->y());
+        }
+        writeValue<uint32_t>(savedFile, i->outputConnections.size());
+        if(!i->outputConnections.empty())
+            savedFile.write(reinterpret_cast<const char*>(&i->outputConnections[0]),
+                            i->outputConnections.size()*sizeof(int32_t));
+    }
+    savedFile.close();
+    if(savedFile.fail() || rename(tmpName.c_str(), fileName.c_str()) != 0)
+    {
+        std::cout << "There was an error writing the checkpoint " << fileName << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool Checkpoint::load(std::string fileName)
+{
+    std::ifstream inputFile(fileName.c_str(), std::ios::in | std::ios::binary);
+    char magic[4];
+    uint32_t version, count;
+    uint64_t size;
+    uint8_t flag;
+    int32_t value;
+    double x, y;
+
+    if (!inputFile.is_open())
+        return false;
+
+    inputFile.read(magic, 4);
+    readValue(inputFile, version);
+    if(!inputFile || strncmp(magic, CHECKPOINT_MAGIC, 4) != 0 || version != CHECKPOINT_VERSION)
+    {
+        std::cout << "Error. " << fileName << " is not a valid checkpoint\n";
+        return false;
+    }
+    readValue(inputFile, value);
+    stage = value;
+    readValue(inputFile, value);
+    seed = value;
+    readString(inputFile, rngName);
+    readValue(inputFile, size);
+    rngState.assign(size, '\0');
+    inputFile.read(&rngState[0], size);
+    readString(inputFile, patternFile);
+    readValue(inputFile, width);
+    readValue(inputFile, height);
+    readValue(inputFile, somaRadius);
+
+    readValue(inputFile, size);
+    neurons.assign(size, neuronState());
+    for(std::vector<neuronState>::iterator i = neurons.begin(); i != neurons.end() && inputFile; i++)
+    {
+        readValue(inputFile, x);
+        readValue(inputFile, y);
+        i->position = Vector2d(x, y);
+        readValue(inputFile, i->somaRadius);
+        readValue(inputFile, i->axonLength);
+        readValue(inputFile, i->dtreeRadius);
+        readValue(inputFile, flag);
+        i->CUXactive = flag;
+        readValue(inputFile, count);
+        for(uint32_t j = 0; j < count; j++)
+        {
+            readValue(inputFile, x);
+            readValue(inputFile, y);
+            i->axonSegments.push_back(Vector2d(x, y));
+        }
+        readValue(inputFile, count);
+        i->outputConnections.resize(count);
+        if(count > 0)
+            inputFile.read(reinterpret_cast<char*>(&i->outputConnections[0]), count*sizeof(int32_t));
+    }
+    if(!inputFile)
+    {
+        std::cout << "Error. The checkpoint " << fileName << " is truncated\n";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _CHECKPOINT_H_
+#define _CHECKPOINT_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <Eigen/Core>
+#include "gsl/gsl_rng.h"
+#include "neuronnamespace.h"
+
+using namespace Eigen;
+
+class Chamber;
+
+// Binary snapshot of the generation state after a given stage: the
+// neurons, the RNG state and the inputs used to build the lattice. The
+// lattice itself is not stored, it is rebuilt from the pattern and the
+// restored somas and dendrites in the original insertion order, so a
+// resumed run is bit-identical to an uninterrupted one.
+class Checkpoint
+{
+    public:
+        Checkpoint();
+        void capture(int stg, int sd, gsl_rng* rng, Chamber* chamber);
+        bool restore(Chamber* chamber, gsl_rng* rng);
+        bool matches(Chamber* chamber);
+        bool save(std::string fileName);
+        bool load(std::string fileName);
+        inline int getStage()
+            {return stage;}
+        inline int getSeed()
+            {return seed;}
+
+    private:
+        typedef struct neuronState
+        {
+            Vector2d position;
+            double somaRadius, axonLength, dtreeRadius;
+            bool CUXactive;
+            std::vector<Vector2d> axonSegments;
+            std::vector<int32_t> outputConnections;
+        } neuronState;
+
+        int stage, seed;
+        std::string rngName;
+        std::vector<char> rngState;
+        // Lattice construction inputs
+        std::string patternFile;
+        double width, height, somaRadius;
+        std::vector<neuronState> neurons;
+};
+
+#endif
+    // _CHECKPOINT_H_
+
@@ -15,6 +15,7 @@
  */
 
 #include "defect.h"
+#include "profiler.h"
 
 Defect::Defect()
 {
@@ -70,6 +71,7 @@ bool Defect::intersect(Defect newDefect, int boundaries, double w, double h)
     double dist, det;
     int k, k1, k2;
 //    double spacing;
+    PROFILE_COUNT(PROFILE_INTERSECTIONS+type*PROFILE_DEFECT_TYPES+newDefect.getDefectType());
     switch(type)
     {
         case DEFECT_TYPE_DISK:
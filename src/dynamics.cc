@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "gsl/gsl_rng.h"
+#include "gsl/gsl_randist.h"
+#include "numpyio.h"
+#include "random.h"
+#include "dynamics.h"
+
+// Neurons are split in this many blocks, each with its own noise stream
+// and spike queue, whatever the number of threads
+#define DYNAMICS_BLOCKS 64
+// Izhikevich spike cutoff (mV)
+#define IZHIKEVICH_PEAK 30.
+
+Dynamics::Dynamics(const Adjacency& adjacency, const std::vector<double>& distances)
+{
+    output = adjacency;
+    edgeDistance = distances;
+    nodes = adjacency.getNodeCount();
+    slots = 1;
+    param = neuron::DEFAULT_DYNAMICS_PARAMETERS;
+}
+
+void Dynamics::setParameters(const neuron::dynamicsParameters& params)
+{
+    param = params;
+}
+
+// Noise, membrane update and spike detection of neurons [first, last)
+void Dynamics::integrate(int first, int last, double time, double* input, gsl_rng* rng,
+                         std::vector<int32_t>& spikes)
+{
+    double dt = param.dt;
+    double* vp = &v[0];
+    double* up = &u[0];
+    double* refractoryp = &refractoryEnd[0];
+
+    // One Poisson count for the whole block, every event lands on a
+    // uniformly chosen neuron. The counts per neuron are the same
+    // independent Poisson draws, but the cost follows the event rate
+    if(param.noiseRate > 0 && last > first)
+    {
+        unsigned int events = gsl_ran_poisson(rng, param.noiseRate*dt/1000.*(last-first));
+        for(unsigned int k = 0; k < events; k++)
+            input[first+gsl_rng_uniform_int(rng, last-first)] += param.noiseAmplitude;
+    }
+
+    // Branch free loops over contiguous arrays so they vectorize
+    if(param.model == neuron::DYNAMICS_LIF)
+    {
+        double decay = dt/param.tau;
+        #pragma omp simd
+        for(int i = first; i < last; i++)
+        {
+            double active = time >= refractoryp[i] ? 1. : 0.;
+            vp[i] += active*(decay*(param.restPotential-vp[i])+input[i]);
+            input[i] = 0;
+        }
+        for(int i = first; i < last; i++)
+        {
+            if(vp[i] >= param.threshold)
+            {
+                spikes.push_back(i);
+                vp[i] = param.resetPotential;
+                refractoryp[i] = time+param.refractory;
+            }
+        }
+    }
+    else
+    {
+        // Two half steps for v, as in Izhikevich (2003)
+        double half = 0.5*dt;
+        #pragma omp simd
+        for(int i = first; i < last; i++)
+        {
+            double vi = vp[i];
+            vi += half*(0.04*vi*vi+5.*vi+140.-up[i]);
+            vi += half*(0.04*vi*vi+5.*vi+140.-up[i]);
+            vi += input[i];
+            up[i] += dt*param.a*(param.b*vi-up[i]);
+            vp[i] = vi;
+            input[i] = 0;
+        }
+        for(int i = first; i < last; i++)
+        {
+            if(vp[i] >= IZHIKEVICH_PEAK)
+            {
+                spikes.push_back(i);
+                vp[i] = param.c;
+                up[i] += param.d;
+            }
+        }
+    }
+}
+
+void Dynamics::run()
+{
+    const std::vector<int64_t>& offsets = output.getOffsets();
+    const std::vector<int32_t>& targets = output.getTargets();
+    int steps = int(param.duration/param.dt+0.5);
+    int blocks = std::max(1, std::min(DYNAMICS_BLOCKS, nodes));
+    int maxDelay = 1;
+    std::vector<gsl_rng*> rng(blocks);
+    std::vector<std::vector<int32_t> > spikes(blocks);
+    std::vector<double> input;
+
+    // Delays in steps, at least one so a spike acts on the next step
+    edgeDelay.resize(targets.size());
+    for(size_t e = 0; e < targets.size(); e++)
+    {
+        double delay = param.delay;
+        if(param.velocity > 0 && e < edgeDistance.size())
+            delay += edgeDistance[e]/param.velocity;
+        edgeDelay[e] = std::max(1, int(delay/param.dt+0.5));
+        maxDelay = std::max(maxDelay, edgeDelay[e]);
+    }
+    slots = maxDelay+1;
+    input.assign(size_t(slots)*nodes, 0);
+
+    if(param.model == neuron::DYNAMICS_LIF)
+    {
+        v.assign(nodes, param.restPotential);
+        u.assign(nodes, 0);
+    }
+    else
+    {
+        v.assign(nodes, param.c);
+        u.assign(nodes, param.b*param.c);
+    }
+    refractoryEnd.assign(nodes, -1);
+    spikeTimes.clear();
+    spikeNeurons.clear();
+    for(int b = 0; b < blocks; b++)
+    {
+        rng[b] = gsl_rng_alloc(gsl_rng_taus2);
+        gsl_rng_set(rng[b], Random::streamSeed(param.seed, b, STREAM_DYNAMICS));
+    }
+
+    std::cout << "Simulating " << param.duration << " ms of activity...\n";
+    for(int step = 0; step < steps; step++)
+    {
+        double time = step*param.dt;
+        double* current = &input[size_t(step%slots)*nodes];
+
+        #pragma omp parallel for schedule(static)
+        for(int b = 0; b < blocks; b++)
+        {
+            spikes[b].clear();
+            integrate(int(int64_t(nodes)*b/blocks), int(int64_t(nodes)*(b+1)/blocks), time, current, rng[b], spikes[b]);
+        }
+
+        // Deliver the spikes to the slots of their arrival step
+        #pragma omp parallel for schedule(dynamic)
+        for(int b = 0; b < blocks; b++)
+        {
+            for(std::vector<int32_t>::iterator i = spikes[b].begin(); i != spikes[b].end(); i++)
+            {
+                for(int64_t e = offsets[*i]; e < offsets[*i+1]; e++)
+                {
+                    double* target = &input[size_t((step+edgeDelay[e])%slots)*nodes+targets[e]];
+                    #pragma omp atomic
+                    *target += param.weight;
+                }
+            }
+        }
+
+        for(int b = 0; b < blocks; b++)
+        {
+            spikeNeurons.insert(spikeNeurons.end(), spikes[b].begin(), spikes[b].end());
+            spikeTimes.insert(spikeTimes.end(), spikes[b].size(), time);
+        }
+    }
+    for(int b = 0; b < blocks; b++)
+        gsl_rng_free(rng[b]);
+    std::cout << spikeTimes.size() << " spikes.\n";
+}
+
+// NumPy archive with spike_times (ms, float64) and spike_neurons (int32),
+// in time order
+bool Dynamics::saveRaster(std::string fileName)
+{
+    NumpyArchive archive(fileName);
+    std::vector<size_t> shape(1, spikeTimes.size());
+
+    if(!archive.isOpen())
+        return false;
+    archive.add("spike_times", NumpyArray(NumpyArray::typeDescriptor('f', 8), shape,
+                                          spikeTimes.empty() ? NULL : &spikeTimes[0], spikeTimes.size()*sizeof(double)));
+    archive.add("spike_neurons", NumpyArray(NumpyArray::typeDescriptor('i', 4), shape,
+                                            spikeNeurons.empty() ? NULL : &spikeNeurons[0], spikeNeurons.size()*sizeof(int32_t)));
+    return archive.close();
+}
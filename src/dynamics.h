@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _DYNAMICS_H_
+#define _DYNAMICS_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "gsl/gsl_rng.h"
+#include "adjacency.h"
+#include "neuronnamespace.h"
+
+// Spiking dynamics over the generated connections. Membranes are
+// integrated with a fixed step over structure of arrays state, spikes are
+// delivered as events through the CSR adjacency into a ring buffer of
+// future inputs indexed by the delay of each connection. The noise of
+// every block of neurons has its own RNG stream.
+class Dynamics
+{
+    public:
+        Dynamics(const Adjacency& adjacency, const std::vector<double>& distances);
+        void setParameters(const neuron::dynamicsParameters& params);
+        void run();
+        bool saveRaster(std::string fileName);
+        inline const std::vector<double>& getSpikeTimes()
+            {return spikeTimes;}
+        inline const std::vector<int32_t>& getSpikeNeurons()
+            {return spikeNeurons;}
+
+    private:
+        void integrate(int first, int last, double time, double* input, gsl_rng* rng, std::vector<int32_t>& spikes);
+
+        neuron::dynamicsParameters param;
+        Adjacency output;
+        // Per connection, soma-soma distance
+        std::vector<double> edgeDistance;
+        std::vector<int> edgeDelay;
+        int slots, nodes;
+        // Neuron state
+        std::vector<double> v, u, refractoryEnd;
+        std::vector<double> spikeTimes;
+        std::vector<int32_t> spikeNeurons;
+};
+
+#endif
+    // _DYNAMICS_H_
+
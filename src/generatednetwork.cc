@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "generatednetwork.h"
+#include "chamber.h"
+
+GeneratedNetwork::GeneratedNetwork()
+{
+    seed = -1;
+    axonOffsets.assign(1, 0);
+}
+
+GeneratedNetwork::GeneratedNetwork(Chamber* chamber, int sd)
+{
+    std::vector<Vector2d> segments;
+    size_t n = chamber->neuron.size();
+
+    seed = sd;
+    positions.reserve(2*n);
+    somaRadii.reserve(n);
+    dendriteRadii.reserve(n);
+    axonLengths.reserve(n);
+    CUXactive.reserve(n);
+    axonOffsets.reserve(n+1);
+    axonOffsets.push_back(0);
+    for(std::vector<Neuron>::iterator i = chamber->neuron.begin(); i != chamber->neuron.end(); i++)
+    {
+        positions.push_back(i->getPosition().x());
+        positions.push_back(i->getPosition().y());
+        somaRadii.push_back(i->getSomaRadius());
+        dendriteRadii.push_back(i->getDtreeRadius());
+        axonLengths.push_back(i->getAxonLength());
+        CUXactive.push_back(i->getCUXactive());
+
+        segments = i->getAxonSegments();
+        for(std::vector<Vector2d>::iterator j = segments.begin(); j != segments.end(); j++)
+        {
+            axonPoints.push_back(j->x());
+            axonPoints.push_back(j->y());
+        }
+        axonOffsets.push_back(axonOffsets.back()+segments.size());
+    }
+    adjacency = Adjacency(chamber->neuron);
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _GENERATEDNETWORK_H_
+#define _GENERATEDNETWORK_H_
+
+#include <vector>
+#include <stdint.h>
+#include "adjacency.h"
+#include "neuronnamespace.h"
+
+class Chamber;
+
+// Read-only copy of a finished network, independent of the chamber and
+// lattice it was generated in. Positions and axon points are stored as
+// interleaved x,y pairs (mm), the axon of neuron i spans the points
+// axonOffsets[i] to axonOffsets[i+1]-1.
+class GeneratedNetwork
+{
+    public:
+        GeneratedNetwork();
+        GeneratedNetwork(Chamber* chamber, int sd);
+        inline int getNeuronCount() const
+            {return int(somaRadii.size());}
+        inline int getSeed() const
+            {return seed;}
+        inline const std::vector<double>& getPositions() const
+            {return positions;}
+        inline const std::vector<double>& getSomaRadii() const
+            {return somaRadii;}
+        inline const std::vector<double>& getDendriteRadii() const
+            {return dendriteRadii;}
+        inline const std::vector<double>& getAxonLengths() const
+            {return axonLengths;}
+        inline const std::vector<int64_t>& getAxonOffsets() const
+            {return axonOffsets;}
+        inline const std::vector<double>& getAxonPoints() const
+            {return axonPoints;}
+        inline const std::vector<char>& getCUXactive() const
+            {return CUXactive;}
+        inline const Adjacency& getAdjacency() const
+            {return adjacency;}
+
+    private:
+        int seed;
+        std::vector<double> positions, somaRadii, dendriteRadii, axonLengths;
+        std::vector<int64_t> axonOffsets;
+        std::vector<double> axonPoints;
+        std::vector<char> CUXactive;
+        Adjacency adjacency;
+};
+
+#endif
+    // _GENERATEDNETWORK_H_
+
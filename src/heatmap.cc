@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <QImage>
+#include "numpyio.h"
+#include "heatmap.h"
+
+const char* const Heatmap::COUNTER_NAMES[HEATMAP_COUNTERS] = {"placement_rejects", "axon_retries", "axon_limits",
+                                                              "range_candidates"};
+
+// Grid of the last heatmap each thread counted on. Heatmaps get unique
+// ids, so a new one at the address of a deleted one is never confused
+typedef struct heatmapCache
+{
+    int owner;
+    uint64_t* grid;
+} heatmapCache;
+static __thread heatmapCache cache = {-1, NULL};
+static int nextId = 0;
+
+Heatmap::Heatmap(Vector2d orig, Vector2d pixel, int widthCount, int heightCount, int scale)
+{
+    scale = scale > 0 ? scale : 1;
+    id = __atomic_fetch_add(&nextId, 1, __ATOMIC_RELAXED);
+    origin = orig;
+    cellSize = pixel*scale;
+    cols = std::max(1, (widthCount+scale-1)/scale);
+    rows = std::max(1, (heightCount+scale-1)/scale);
+    cells = cols*rows;
+    pthread_mutex_init(&mutex, NULL);
+}
+
+Heatmap::~Heatmap()
+{
+    for(std::vector<uint64_t*>::iterator i = grids.begin(); i != grids.end(); i++)
+        delete[] *i;
+    pthread_mutex_destroy(&mutex);
+}
+
+uint64_t* Heatmap::localGrid()
+{
+    if(cache.owner != id)
+    {
+        cache.grid = registerThread();
+        cache.owner = id;
+    }
+    return cache.grid;
+}
+
+// A thread coming back after counting on another heatmap keeps its grid
+uint64_t* Heatmap::registerThread()
+{
+    uint64_t* grid = NULL;
+    pthread_t self = pthread_self();
+
+    pthread_mutex_lock(&mutex);
+    for(size_t i = 0; i < owners.size(); i++)
+    {
+        if(pthread_equal(owners[i], self))
+        {
+            grid = grids[i];
+            break;
+        }
+    }
+    if(!grid)
+    {
+        grid = new uint64_t[size_t(HEATMAP_COUNTERS)*cells]();
+        owners.push_back(self);
+        grids.push_back(grid);
+    }
+    pthread_mutex_unlock(&mutex);
+    return grid;
+}
+
+// Sum of every thread grid, rows*cols values, row major
+std::vector<int64_t> Heatmap::reduce(int counter)
+{
+    std::vector<int64_t> total(cells, 0);
+
+    pthread_mutex_lock(&mutex);
+    for(std::vector<uint64_t*>::iterator i = grids.begin(); i != grids.end(); i++)
+    {
+        uint64_t* grid = *i+size_t(counter)*cells;
+        for(int c = 0; c < cells; c++)
+            total[c] += grid[c];
+    }
+    pthread_mutex_unlock(&mutex);
+    return total;
+}
+
+// One (rows, cols) int64 array per counter, <prefix><counter>.npy
+bool Heatmap::saveNumpy(std::string prefix)
+{
+    std::vector<size_t> shape;
+    bool success = true;
+
+    shape.push_back(rows);
+    shape.push_back(cols);
+    for(int k = 0; k < HEATMAP_COUNTERS; k++)
+    {
+        std::vector<int64_t> total = reduce(k);
+        success &= NumpyFile::save(prefix+COUNTER_NAMES[k]+".npy",
+                                   NumpyArray(NumpyArray::typeDescriptor('i', 8), shape, &total[0],
+                                              total.size()*sizeof(int64_t)));
+    }
+    return success;
+}
+
+// One image per counter, <prefix><counter>.png. Black to red to yellow to
+// white, on a logarithmic scale up to the largest count of the map
+bool Heatmap::savePNG(std::string prefix)
+{
+    bool success = true;
+    double maximum, level;
+    int r, g, b;
+
+    for(int k = 0; k < HEATMAP_COUNTERS; k++)
+    {
+        std::vector<int64_t> total = reduce(k);
+        QImage image(cols, rows, QImage::Format_RGB32);
+        maximum = 0;
+        for(int c = 0; c < cells; c++)
+            maximum = std::max(maximum, double(total[c]));
+        for(int y = 0; y < rows; y++)
+        {
+            for(int x = 0; x < cols; x++)
+            {
+                level = maximum > 0 ? 3*log1p(double(total[y*cols+x]))/log1p(maximum) : 0;
+                r = int(255*std::min(1., level));
+                g = int(255*std::min(1., std::max(0., level-1)));
+                b = int(255*std::min(1., std::max(0., level-2)));
+                image.setPixel(x, y, qRgb(r, g, b));
+            }
+        }
+        if(!image.save((prefix+COUNTER_NAMES[k]+".png").c_str(), "PNG"))
+        {
+            std::cout << "There was an error opening file " << prefix+COUNTER_NAMES[k] << ".png\n";
+            success = false;
+        }
+    }
+    return success;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _HEATMAP_H_
+#define _HEATMAP_H_
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+#include <Eigen/Core>
+
+using namespace Eigen;
+
+enum heatmapCounter
+{
+    HEATMAP_PLACEMENT_REJECTS,
+    HEATMAP_AXON_RETRIES,
+    HEATMAP_AXON_LIMITS,
+    HEATMAP_RANGE_CANDIDATES,
+    HEATMAP_COUNTERS
+};
+
+// Where the generation spends its retries: rejected soma proposals, axon
+// segment retries, axons that hit the retry limit and lattice candidates
+// per range query, counted on a raster over the pattern grid (cells of
+// scale x scale pixels, row 0 at the top as in the image). Positions
+// outside the pattern are wrapped. Every thread counts on its own grid,
+// the grids are added up when the maps are saved.
+class Heatmap
+{
+    public:
+        Heatmap(Vector2d orig, Vector2d pixel, int widthCount, int heightCount, int scale);
+        ~Heatmap();
+        inline void count(int counter, const Vector2d& position, uint64_t amount = 1)
+            {localGrid()[counter*cells+cell(position)] += amount;}
+        std::vector<int64_t> reduce(int counter);
+        bool saveNumpy(std::string prefix);
+        bool savePNG(std::string prefix);
+        static const char* const COUNTER_NAMES[HEATMAP_COUNTERS];
+
+    private:
+        Heatmap(const Heatmap&);
+        Heatmap& operator=(const Heatmap&);
+        inline int cell(const Vector2d& position)
+            {int x = int(floor((position.x()-origin.x())/cellSize.x())) % cols;
+             int y = int(floor((origin.y()-position.y())/cellSize.y())) % rows;
+             return (y < 0 ? y+rows : y)*cols+(x < 0 ? x+cols : x);}
+        uint64_t* localGrid();
+        uint64_t* registerThread();
+
+        int id;
+        Vector2d origin, cellSize;
+        int cols, rows, cells;
+        pthread_mutex_t mutex;
+        std::vector<pthread_t> owners;
+        std::vector<uint64_t*> grids;
+};
+
+#endif
+    // _HEATMAP_H_
+
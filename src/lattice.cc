@@ -16,10 +16,13 @@
 
 #include "defect.h"
 #include "lattice.h"
+#include "profiler.h"
 
 Lattice::Lattice()
 {
-
+    defectPosition = NULL;
+    widthCount = heightCount = 0;
+    base = NULL;
 }
 
 Lattice::Lattice(int boundaries, Vector2d orig, double unitWidth, double unitHeight, double wid, double hei)
@@ -41,6 +44,42 @@ Lattice::Lattice(int boundaries, Vector2d orig, double unitWidth, double unitHei
     defectPosition = new std::vector<Defect*>*[widthCount];
     for (int i = 0; i < widthCount; i++)
         defectPosition[i] = new std::vector<Defect*>[heightCount];
+    base = NULL;
+}
+
+// Empty lattice with the same geometry that sees every defect of shared.
+// Used by ensembles so the pattern defects are only built once. Queries
+// return the shared defects of each cell first, which is the same order
+// they would have if they had been added to this lattice.
+Lattice::Lattice(Lattice* shared)
+{
+    boundaryConditions = shared->boundaryConditions;
+    origin = shared->origin;
+    e1 = shared->e1;
+    e2 = shared->e2;
+    widthCount = shared->widthCount;
+    heightCount = shared->heightCount;
+
+    defectPosition = new std::vector<Defect*>*[widthCount];
+    for (int i = 0; i < widthCount; i++)
+        defectPosition[i] = new std::vector<Defect*>[heightCount];
+    base = shared;
+}
+
+Lattice::~Lattice()
+{
+    for (int i = 0; i < widthCount; i++)
+        delete [] defectPosition[i];
+    delete [] defectPosition;
+}
+
+std::list<Defect> Lattice::getAllDefects()
+{
+    std::list<Defect> dlist;
+    if(base)
+        dlist = base->getAllDefects();
+    dlist.insert(dlist.end(), defectList.begin(), defectList.end());
+    return dlist;
 }
 
 // Create a defect and attach it to the associated lattice points
@@ -193,10 +232,15 @@ std::list<Defect> Lattice::getDefectsInRange(std::vector<Vector2d> bounds)
         default:
             for(int k = mine1; k <= maxe1; k++)
                 for(int l = mine2; l <= maxe2; l++)
+                {
+                    if(base)
+                        for(std::vector<Defect*>::iterator m = base->defectPosition[k][l].begin(); m != base->defectPosition[k][l].end(); m++)
+                            dlist.push_back(*(*m));
                     for(std::vector<Defect*>::iterator m = defectPosition[k][l].begin(); m != defectPosition[k][l].end(); m++)
                     {
                         dlist.push_back(*(*m));
                     }
+                }
             break;
 /*        case LATTICE_BOUNDARIES_PERIODIC:
             // Overflows
@@ -255,6 +299,8 @@ std::list<Defect> Lattice::getDefectsInRange(std::vector<Vector2d> bounds)
 
         //std::cout << "1.9\n";
 //    }
+    PROFILE_COUNT(PROFILE_RANGE_QUERIES);
+    PROFILE_ADD(PROFILE_RANGE_CANDIDATES, dlist.size());
     return dlist;
 }
 
@@ -34,6 +34,8 @@ class Lattice
     public:
         Lattice();
         Lattice(int boundaries, Vector2d orig, double unitWidth, double unitHeight, double wid, double hei);
+        Lattice(Lattice* shared);
+        ~Lattice();
         bool addDefect(Defect def);
         bool firstBoundaryOverflow(Vector2d point);
         bool secondBoundaryOverflow(Vector2d point);
@@ -46,8 +48,7 @@ class Lattice
         Vector2i getClosestLatticePoint(Vector2d point);
         Vector2d fromAbsoluteToPeriodic(Vector2d point);
         std::list<Defect> getDefectsInRange(std::vector<Vector2d> bounds);
-       inline std::list<Defect> getAllDefects()
-           {return defectList;}
+        std::list<Defect> getAllDefects();
 
     private:
         int boundaryConditions;
@@ -56,7 +57,9 @@ class Lattice
         int widthCount, heightCount;
         std::list<Defect> defectList;
         std::vector<Defect*> **defectPosition;
-        
+        // Read-only lattice whose defects are also returned by the queries
+        Lattice* base;
+
 };
 
 #endif
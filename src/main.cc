@@ -18,21 +18,40 @@
 #include <iostream>
 #include "main.h"
 #include "network.h"
+#include "server.h"
 
 int main(int argc, char *argv[])
 {
     std::stringstream configFile;
     Network *network;
+    bool serve = false;
     network = new Network();
 
-  	if (argc > 1)
-  	{
-    	configFile << argv[1];
-    	std::cout << "Loading Config File: " << configFile.str() << "\n";
-    	network->loadConfigFile(configFile.str());
- 	}
-	else
-    network->loadConfigFile("config.cfg");
+    configFile << "config.cfg";
+    for(int i = 1; i < argc; i++)
+    {
+        if(std::string(argv[i]) == "--resume")
+            network->setResume(true);
+        else if(std::string(argv[i]) == "--serve")
+            serve = true;
+        else if(std::string(argv[i]) == "--quiet")
+            network->setQuiet(true);
+        else
+        {
+            configFile.str(argv[i]);
+            std::cout << "Loading Config File: " << configFile.str() << "\n";
+        }
+    }
+    if(serve)
+    {
+        Server server;
+        if(!server.load(configFile.str()))
+            return 1;
+        server.run();
+        return 0;
+    }
+    if(!network->loadConfigFile(configFile.str()))
+        return 1;
 
     return 0;
 }
@@ -20,11 +20,151 @@
 #include <sys/types.h>
 #include <stdio.h> // for FILENAMEMAX
 #include <string.h>
+#include <ctype.h>
 #include <fstream>
+#include <iomanip>
 #include "gsl/gsl_rng.h"
 #include "gsl/gsl_randist.h"
 #include "network.h"
+#include "adjacency.h"
+#include "axonbatch.h"
+#include "numpyio.h"
+#include "checkpoint.h"
+#include "dynamics.h"
+#include "nullmodel.h"
+#include "percolation.h"
+#include "profiler.h"
+#include "progress.h"
+#include "quorum.h"
+#include "random.h"
+#include "statistics.h"
+#include "surrogate.h"
+#include "sweep.h"
 #include <exception>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Contiguous copies of the per neuron data, shared by the .npy and .npz writers
+typedef struct numpyBuffers
+{
+    std::vector<double> positions, sizes, axonPoints;
+    std::vector<int64_t> axonOffsets;
+    std::vector<int32_t> sources;
+    std::vector<int8_t> weights;
+    Adjacency adjacency;
+} numpyBuffers;
+
+// True if the printf style template has a single %d (or %i) conversion,
+// with optional flags, width and precision, and no other conversion
+static bool singleIntTemplate(const std::string& name)
+{
+    int conversions = 0;
+    size_t i = 0;
+    while(i < name.size())
+    {
+        if(name[i++] != '%')
+            continue;
+        if(i < name.size() && name[i] == '%')
+        {
+            i++;
+            continue;
+        }
+        while(i < name.size() && strchr("-+ #0", name[i]))
+            i++;
+        while(i < name.size() && (isdigit(name[i]) || name[i] == '.'))
+            i++;
+        if(i == name.size() || (name[i] != 'd' && name[i] != 'i'))
+            return false;
+        i++;
+        conversions++;
+    }
+    return conversions == 1;
+}
+
+template <class T> static const void* bufferOf(const std::vector<T>& v)
+{
+    return v.empty() ? NULL : &v[0];
+}
+
+static void collectNumpyArrays(Chamber* chamber, numpyBuffers& buffers,
+                               std::vector<std::string>& names, std::vector<NumpyArray>& arrays)
+{
+    size_t n = chamber->neuron.size();
+    size_t columns = chamber->getDtreeParameters().CUX ? 7 : 6;
+    std::vector<Vector2d> segments;
+    std::vector<size_t> shape;
+    Vector2d position;
+
+    buffers.positions.reserve(2*n);
+    buffers.sizes.reserve(columns*n);
+    buffers.axonOffsets.reserve(n+1);
+    buffers.axonOffsets.push_back(0);
+    for(std::vector<Neuron>::iterator i = chamber->neuron.begin(); i != chamber->neuron.end(); i++)
+    {
+        position = i->getPosition();
+        buffers.positions.push_back(position.x());
+        buffers.positions.push_back(position.y());
+
+        buffers.sizes.push_back(i->getSomaRadius());
+        buffers.sizes.push_back(i->getDtreeRadius());
+        buffers.sizes.push_back(i->getAxonLength());
+        buffers.sizes.push_back(i->getAxonEndToEndDistance());
+        buffers.sizes.push_back(i->getInputConnections().size());
+        buffers.sizes.push_back(i->getOutputConnections().size());
+        if(columns == 7)
+            buffers.sizes.push_back(i->getCUXactive());
+
+        segments = i->getAxonSegments();
+        for(std::vector<Vector2d>::iterator j = segments.begin(); j != segments.end(); j++)
+        {
+            buffers.axonPoints.push_back(j->x());
+            buffers.axonPoints.push_back(j->y());
+        }
+        buffers.axonOffsets.push_back(buffers.axonOffsets.back()+segments.size());
+    }
+    buffers.adjacency = Adjacency(chamber->neuron);
+    buffers.sources = buffers.adjacency.getSources();
+    buffers.weights.assign(buffers.sources.size(), 1);
+
+    shape.clear(); shape.push_back(n); shape.push_back(2);
+    names.push_back("positions");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('f', 8), shape, bufferOf(buffers.positions),
+                                buffers.positions.size()*sizeof(double)));
+    shape.clear(); shape.push_back(n); shape.push_back(columns);
+    names.push_back("sizes");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('f', 8), shape, bufferOf(buffers.sizes),
+                                buffers.sizes.size()*sizeof(double)));
+    shape.clear(); shape.push_back(n+1);
+    names.push_back("axon_offsets");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('i', 8), shape, bufferOf(buffers.axonOffsets),
+                                buffers.axonOffsets.size()*sizeof(int64_t)));
+    shape.clear(); shape.push_back(buffers.axonPoints.size()/2); shape.push_back(2);
+    names.push_back("axon_points");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('f', 8), shape, bufferOf(buffers.axonPoints),
+                                buffers.axonPoints.size()*sizeof(double)));
+
+    // CSR and COO share the column and data arrays (rows are in CSR order)
+    const std::vector<int64_t>& offsets = buffers.adjacency.getOffsets();
+    const std::vector<int32_t>& targets = buffers.adjacency.getTargets();
+    shape.clear(); shape.push_back(offsets.size());
+    names.push_back("csr_indptr");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('i', 8), shape, bufferOf(offsets),
+                                offsets.size()*sizeof(int64_t)));
+    shape.clear(); shape.push_back(targets.size());
+    names.push_back("csr_indices");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('i', 4), shape, bufferOf(targets),
+                                targets.size()*sizeof(int32_t)));
+    names.push_back("coo_row");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('i', 4), shape, bufferOf(buffers.sources),
+                                buffers.sources.size()*sizeof(int32_t)));
+    names.push_back("coo_col");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('i', 4), shape, bufferOf(targets),
+                                targets.size()*sizeof(int32_t)));
+    names.push_back("adjacency_data");
+    arrays.push_back(NumpyArray(NumpyArray::typeDescriptor('i', 1), shape, bufferOf(buffers.weights),
+                                buffers.weights.size()*sizeof(int8_t)));
+}
 
 Network::Network()
 {
@@ -37,36 +177,319 @@ Network::Network(neuron::chamberParameters p)
     addChamber(p);
 }
 
+Network::~Network()
+{
+    delete chamber;
+    if(rng)
+        gsl_rng_free(rng);
+    delete configFile;
+}
+
 void Network::init()
 {
     chamber = NULL;
+    chamberParams = neuron::DEFAULT_CHAMBER_PARAMETERS;
+    cultureParams = neuron::DEFAULT_CULTURE_PARAMETERS;
+    somaParams = neuron::DEFAULT_SOMA_PARAMETERS;
+    dtreeParams = neuron::DEFAULT_DTREE_PARAMETERS;
+    axonParams = neuron::DEFAULT_AXON_PARAMETERS;
+    rng = NULL;
+    configFile = NULL;
+    ensembleActive = false;
+    surrogateActive = false;
+    surrogateRuns = 1;
+    surrogateNeurons = 0;
+    surrogateBinWidth = 0.01;
+    surrogateMaxDistance = 2.0;
+    ensembleCount = 0;
+    ensembleSeedBase = 0;
+    ensembleThreads = 0;
+    inputActive = false;
+    resume = false;
+    checkpointActive = false;
+    fixedSeed = -1;
+    rngEngine = RANDOM_GSL;
+    statisticsMetrics = 0;
+    statisticsPathSamples = 100;
+    profileBinWidth = 0.01;
+    profileMaxDistance = 2.0;
+    percolationMode = neuron::PERCOLATION_BOND;
+    percolationSweeps = 100;
+    percolationPoints = 100;
+    dynamicsParams = neuron::DEFAULT_DYNAMICS_PARAMETERS;
+    quorumThreshold = 15;
+    quorumRuns = 100;
+    quorumFrom = 0;
+    quorumTo = 0.2;
+    quorumPoints = 41;
+    nullModelMode = neuron::NULL_MODEL_DEGREE;
+    nullModelCount = 1;
+    nullModelSwaps = 10;
+    nullModelBinWidth = 0.05;
+    heatmapScale = 1;
+    heatmapPNG = false;
+    progress = NULL;
+    progressData = NULL;
+    progressQuiet = false;
+    progressInterval = 1.0;
 }
 
 void Network::addChamber(neuron::chamberParameters p)
 {
+    chamberParams = p;
     if(chamber)
         delete chamber;
     chamber = new Chamber(p);
 }
 
-void Network::generate()
+void Network::runStage(int stage)
 {
-    seedRNG();
+    PROFILE_STAGE(stage);
+    chamber->setProgressOutput(progressQuiet, progressInterval, Progress::openStream(progressStreamFile), seed);
+    if(!heatmapPrefix.empty() && stage >= neuron::STAGE_PLACEMENT)
+        chamber->enableHeatmap(heatmapScale);
+    switch(stage)
+    {
+        case neuron::STAGE_PATTERN:
+            chamber->assignPatternDefects();
+            break;
+        case neuron::STAGE_DENSITY_MAP:
+            chamber->assignDensityMap();
+            break;
+        case neuron::STAGE_PLACEMENT:
+            if(inputActive)
+                loadPositionalMap(inputPositionsFile);
+            else
+                chamber->insertNeurons();
+            break;
+        case neuron::STAGE_AXONS:
+            if(inputActive)
+                loadAxonalMap(inputAxonsFile);
+            else
+                chamber->growAxons();
+            break;
+        case neuron::STAGE_DENDRITES:
+            chamber->growDendrites();
+            break;
+        case neuron::STAGE_CONNECTIONS:
+            if(!profileFile.empty())
+                chamber->setConnectionProfile(profileBinWidth, profileMaxDistance);
+            chamber->growConnections();
+            break;
+    }
+    // The chamber reports the progress of the later stages itself
+    if(progress && stage < neuron::STAGE_PLACEMENT)
+        progress(stage, 1, 1, progressData);
+}
+
+// Each key hashes the fields read by its stage together with the previous key
+void Network::computeStageKeys(uint64_t* keys)
+{
+    neuron::chamberParameters cparams = chamberParams;
+    neuron::cultureParameters cultparams = cultureParams;
+    neuron::somaParameters somaparams = somaParams;
+    neuron::dtreeParameters dtreeparams = dtreeParams;
+    neuron::axonParameters axonparams = axonParams;
+    std::stringstream fields[neuron::STAGE_COUNT];
+
+    for(int i = 0; i < neuron::STAGE_COUNT; i++)
+        fields[i] << std::setprecision(17) << neuron::STAGE_NAMES[i] << " ";
+
+    fields[neuron::STAGE_NONE] << "seed " << seed;
+    // Keys of the default engine stay as they were
+    if(rngEngine != RANDOM_GSL)
+        fields[neuron::STAGE_NONE] << " rng " << rngEngine;
+    fields[neuron::STAGE_PATTERN] << cparams.width << " " << cparams.height << " " << somaparams.radius;
+    fields[neuron::STAGE_DENSITY_MAP] << cparams.densityMap << " " << cparams.densityMapBinWidth << " "
+                                      << cparams.densityMapBinHeight;
+    fields[neuron::STAGE_PLACEMENT] << cultparams.neuronNumber << " " << cultparams.placementDistribution << " "
+                                    << somaparams.radius << " " << inputActive;
+    fields[neuron::STAGE_AXONS] << axonparams.type << " " << axonparams.lengthDistribution << " "
+                                << axonparams.initialAngleDistribution << " " << axonparams.segmentAngleDistribution << " "
+                                << axonparams.meanLength << " " << axonparams.stdLength << " "
+                                << axonparams.meanInitialAngle << " " << axonparams.stdInitialAngle << " "
+                                << axonparams.meanSegmentAngle << " " << axonparams.stdSegmentAngle << " "
+                                << axonparams.width << " " << axonparams.segmentLength << " "
+                                << axonparams.maxStdSegmentAngle << " " << axonparams.segmentCount << " "
+                                << axonparams.maxRetries << " " << axonparams.segmentType << " "
+                                << axonparams.collisionMode << " " << axonparams.collisionFlags << " "
+                                << axonparams.growthMode << " " << axonparams.steering << " "
+                                << axonparams.batch << " " << inputActive;
+    fields[neuron::STAGE_DENDRITES] << dtreeparams.type << " " << dtreeparams.shape << " "
+                                    << dtreeparams.sizeDistribution << " " << dtreeparams.meanRadius << " "
+                                    << dtreeparams.stdRadius << " " << dtreeparams.CUX << " "
+                                    << dtreeparams.CUXfraction << " " << dtreeparams.CUXmultiplier;
+
+    keys[neuron::STAGE_NONE] = StageCache::hash(fields[neuron::STAGE_NONE].str());
+    for(int i = neuron::STAGE_PATTERN; i < neuron::STAGE_COUNT; i++)
+    {
+        keys[i] = StageCache::hash(fields[i].str(), keys[i-1]);
+        // Contents of the input files
+        if(i == neuron::STAGE_PATTERN)
+            keys[i] = StageCache::hashFile(cparams.patternFile, keys[i]);
+        if(i == neuron::STAGE_DENSITY_MAP && cparams.densityMap)
+            keys[i] = StageCache::hashFile(cparams.densityMapFile, keys[i]);
+        if(i == neuron::STAGE_PLACEMENT && inputActive)
+            keys[i] = StageCache::hashFile(inputPositionsFile, keys[i]);
+        if(i == neuron::STAGE_AXONS && inputActive)
+            keys[i] = StageCache::hashFile(inputAxonsFile, keys[i]);
+    }
+}
+
+// Runs (or resumes) the generation stages. Returns false if the
+// checkpoint can't be resumed
+bool Network::generate()
+{
+    Checkpoint snapshot, cached;
+    int completed = neuron::STAGE_NONE;
+    uint64_t keys[neuron::STAGE_COUNT];
+
+    if(resume && snapshot.load(checkpointFile))
+    {
+        if(!snapshot.matches(chamber))
+        {
+            std::cout << "Error. The checkpoint " << checkpointFile << " was generated with a different pattern\n";
+            return false;
+        }
+        completed = snapshot.getStage();
+        seedRNG(snapshot.getSeed());
+        std::cout << "Resuming after stage: " << neuron::STAGE_NAMES[completed] << "\n";
+    }
+    else
+    {
+        if(resume)
+            std::cout << "No checkpoint found in " << checkpointFile << ". Starting from scratch\n";
+        seedRNG(fixedSeed);
+    }
+
+    // Reuse the latest cached stage whose inputs did not change
+    computeStageKeys(keys);
+    if(cache.isActive())
+    {
+        for(int stage = neuron::STAGE_CONNECTIONS; stage > completed && stage >= neuron::STAGE_PLACEMENT; stage--)
+        {
+            if(cache.load(keys[stage], cached) && cached.getStage() == stage && cached.matches(chamber))
+            {
+                snapshot = cached;
+                completed = stage;
+                std::cout << "Using cached stage: " << neuron::STAGE_NAMES[stage] << "\n";
+                break;
+            }
+        }
+    }
+
     chamber->assignLattice();
-    chamber->assignPatternDefects();
+    // Pattern defects are only read by placement and axon growth, the
+    // density map only by placement. Skip them when those are restored
+    if(completed < neuron::STAGE_AXONS)
+        runStage(neuron::STAGE_PATTERN);
+    if(completed < neuron::STAGE_PLACEMENT)
+        runStage(neuron::STAGE_DENSITY_MAP);
+    // Everything up to the completed stage comes from the snapshot
+    if(completed != neuron::STAGE_NONE && !snapshot.restore(chamber, rng))
+        return false;
+
+    for(int stage = completed+1; stage < neuron::STAGE_COUNT; stage++)
+    {
+        if(stage >= neuron::STAGE_PLACEMENT)
+            runStage(stage);
+        if(checkpointActive)
+        {
+            snapshot.capture(stage, seed, rng, chamber);
+            snapshot.save(checkpointFile);
+        }
+        if(cache.isActive() && stage >= neuron::STAGE_PLACEMENT)
+        {
+            snapshot.capture(stage, seed, rng, chamber);
+            cache.store(keys[stage], snapshot);
+        }
+    }
+    return true;
+}
 
-    chamber->assignDensityMap();
+// Copy of the network settings on a chamber that shares the pattern, the
+// pattern defects and the density map of this one
+Network* Network::createRealization()
+{
+    Network* realization = new Network(*this);
+    realization->chamber = chamber->createRealization();
+    realization->rng = NULL;
+    realization->configFile = NULL;
+    realization->resume = false;
+    realization->checkpointActive = false;
+    realization->cache = StageCache();
+    return realization;
+}
 
-    chamber->insertNeurons();
-    chamber->growAxons();
-    if(inputActive)
+// The pattern, the pattern defects and the density map tables are built
+// once, then the realizations only run the stochastic stages, each one on
+// its own chamber and RNG stream, derived from seed_base and the
+// realization index with Random::streamSeed
+void Network::generateEnsemble()
+{
+    int finished = 0;
+    seedRNG(fixedSeed);
+    chamber->assignLattice();
+    runStage(neuron::STAGE_PATTERN);
+    runStage(neuron::STAGE_DENSITY_MAP);
+
+#ifdef _OPENMP
+    if(ensembleThreads > 0)
+        omp_set_num_threads(ensembleThreads);
+#endif
+    std::cout << "Generating " << ensembleCount << " realizations...\n";
+    #pragma omp parallel for schedule(dynamic)
+    for(int r = 0; r < ensembleCount; r++)
     {
-        loadPositionalMap(inputPositionsFile);
-        loadAxonalMap(inputAxonsFile);
+        char prefix[FILENAME_MAX];
+        Network* realization = createRealization();
+
+        snprintf(prefix, FILENAME_MAX, ensembleFiles.c_str(), r);
+        realization->seedRNG(int(Random::streamSeed(ensembleSeedBase, r, STREAM_ENSEMBLE) & 0x7fffffff));
+        for(int stage = neuron::STAGE_PLACEMENT; stage < neuron::STAGE_COUNT; stage++)
+            realization->runStage(stage);
+        realization->saveOutputs(prefix);
+        delete realization;
+
+        #pragma omp critical
+        {
+            finished++;
+            std::cout << "Realization " << r << " done (" << finished << "/" << ensembleCount << ")\n";
+        }
     }
+}
+
+// The kernel is measured on exact realizations of the culture (seeds
+// seed+1, seed+2...), optionally smaller than the network. Then the somas
+// of this network are placed as usual and the connections are sampled
+// from the kernel, axons are not grown
+void Network::generateSurrogate()
+{
+    Surrogate surrogate(surrogateBinWidth, surrogateMaxDistance);
 
-    chamber->growDendrites();
-    chamber->growConnections();
+    seedRNG(fixedSeed);
+    chamber->assignLattice();
+    runStage(neuron::STAGE_PATTERN);
+    runStage(neuron::STAGE_DENSITY_MAP);
+    for(int r = 0; r < surrogateRuns; r++)
+    {
+        Network* calibration = createRealization();
+
+        std::cout << "Calibration run " << r << "...\n";
+        calibration->profileFile.clear();
+        calibration->seedRNG(seed+1+r);
+        calibration->chamber->insertNeurons(surrogateNeurons);
+        for(int stage = neuron::STAGE_AXONS; stage < neuron::STAGE_COUNT; stage++)
+            calibration->runStage(stage);
+        surrogate.calibrate(calibration->chamber);
+        delete calibration;
+    }
+
+    runStage(neuron::STAGE_PLACEMENT);
+    runStage(neuron::STAGE_DENDRITES);
+    surrogate.connect(chamber, seed);
+    if(!surrogateReport.empty() && surrogate.saveReport(surrogateReport))
+        std::cout << "Surrogate report saved.\n";
 }
 
 void Network::activateZone(std::vector<float> zone)
@@ -188,6 +611,263 @@ void Network::saveGexf(std::string fileName)
     std::cout << "GEXF file created.\n";
 }
 
+// One .npy file per array: <prefix>positions.npy, <prefix>csr_indptr.npy...
+void Network::saveNumpy(std::string prefix)
+{
+    numpyBuffers buffers;
+    std::vector<std::string> names;
+    std::vector<NumpyArray> arrays;
+
+    collectNumpyArrays(chamber, buffers, names, arrays);
+    for(size_t i = 0; i < arrays.size(); i++)
+        if(!NumpyFile::save(prefix+names.at(i)+".npy", arrays.at(i)))
+            return;
+    std::cout << "NumPy arrays saved.\n";
+}
+
+// Same arrays bundled in an uncompressed archive, loadable with np.load
+void Network::saveNumpyArchive(std::string fileName)
+{
+    NumpyArchive archive(fileName);
+
+    if(archive.isOpen() && writeNumpyArchive(archive))
+        std::cout << "NumPy archive saved.\n";
+}
+
+// Adds every array to an open archive and closes it
+bool Network::writeNumpyArchive(NumpyArchive& archive)
+{
+    numpyBuffers buffers;
+    std::vector<std::string> names;
+    std::vector<NumpyArray> arrays;
+
+    collectNumpyArrays(chamber, buffers, names, arrays);
+    for(size_t i = 0; i < arrays.size(); i++)
+        if(!archive.add(names.at(i), arrays.at(i)))
+            return false;
+    return archive.close();
+}
+
+// Histograms of candidate and connected pairs against soma distance. They
+// are filled during the connection search, or here if the connections
+// were restored from a checkpoint
+void Network::saveConnectionProfile(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+    double binWidth;
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return;
+    }
+    if(!chamber->hasConnectionProfile())
+    {
+        chamber->setConnectionProfile(profileBinWidth, profileMaxDistance);
+        chamber->computeConnectionProfile();
+    }
+    const std::vector<int64_t>& candidates = chamber->getProfileCandidates();
+    const std::vector<int64_t>& connected = chamber->getProfileConnected();
+    binWidth = chamber->getProfileBinWidth();
+
+    savedFile << "% Connection probability against soma distance\n";
+    savedFile << "% distance_from distance_to candidate_pairs connected_pairs probability\n";
+    for(size_t i = 0; i < candidates.size(); i++)
+    {
+        savedFile << i*binWidth << " " << (i+1)*binWidth << " " << candidates[i] << " " << connected[i] << " "
+                  << (candidates[i] > 0 ? double(connected[i])/candidates[i] : 0) << "\n";
+    }
+    savedFile.close();
+    std::cout << "Connection profile saved.\n";
+}
+
+// Simulates the activity of the network and saves the spike raster. The
+// connection delays use the soma-soma distance of every connection
+void Network::saveRaster(std::string fileName)
+{
+    Adjacency adjacency(chamber->neuron);
+    const std::vector<int64_t>& offsets = adjacency.getOffsets();
+    const std::vector<int32_t>& targets = adjacency.getTargets();
+    std::vector<double> distances(targets.size());
+    neuron::dynamicsParameters params = dynamicsParams;
+
+    for(int i = 0; i < adjacency.getNodeCount(); i++)
+        for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+            distances[e] = (chamber->neuron[targets[e]].getPosition()-chamber->neuron[i].getPosition()).norm();
+
+    Dynamics dynamics(adjacency, distances);
+    params.seed = seed;
+    dynamics.setParameters(params);
+    dynamics.run();
+    if(dynamics.saveRaster(fileName))
+        std::cout << "Spike raster saved.\n";
+}
+
+// Final active fraction against the initial one
+void Network::saveQuorum(std::string fileName)
+{
+    Quorum quorum(Adjacency(chamber->neuron));
+    std::vector<double> f(quorumPoints);
+
+    for(int k = 0; k < quorumPoints; k++)
+        f[k] = quorumPoints > 1 ? quorumFrom+(quorumTo-quorumFrom)*k/(quorumPoints-1) : quorumFrom;
+    std::cout << "Computing quorum percolation...\n";
+    quorum.sweep(f, quorumThreshold, quorumRuns, seed);
+    if(quorum.save(fileName))
+        std::cout << "Quorum percolation saved.\n";
+}
+
+// Each null model takes the place of the connections while the connection
+// outputs (list, gexf, npy, npz and mtx) are written with the names
+// <prefix><null_model.prefix><k>_<file>. The RNG of model k is seeded
+// with Random::streamSeed(seed, k, STREAM_NULL_MODEL)
+void Network::saveNullModels(std::string prefix)
+{
+    Adjacency adjacency(chamber->neuron);
+    size_t n = chamber->neuron.size();
+    std::vector<std::vector<Neuron*> > outputs(n), inputs(n);
+    std::vector<double> x(n), y(n);
+    std::stringstream tmpStr;
+    int64_t accepted;
+
+    for(size_t i = 0; i < n; i++)
+    {
+        outputs[i] = chamber->neuron[i].getOutputConnections();
+        inputs[i] = chamber->neuron[i].getInputConnections();
+        x[i] = chamber->neuron[i].getPosition().x();
+        y[i] = chamber->neuron[i].getPosition().y();
+    }
+
+    for(int k = 0; k < nullModelCount; k++)
+    {
+        NullModel model(adjacency);
+        model.setPositions(x, y, nullModelBinWidth);
+        std::cout << "Rewiring null model " << k << "...\n";
+        accepted = model.rewire(nullModelMode, nullModelSwaps, seed, k);
+        std::cout << "Accepted " << accepted << " swaps for " << adjacency.getEdgeCount() << " connections.\n";
+
+        Adjacency rewired = model.getAdjacency();
+        Adjacency transposed = rewired.transpose();
+        std::vector<Neuron*> connections;
+        for(size_t i = 0; i < n; i++)
+        {
+            connections.clear();
+            for(int64_t e = rewired.getOffsets()[i]; e < rewired.getOffsets()[i+1]; e++)
+                connections.push_back(&chamber->neuron[rewired.getTargets()[e]]);
+            chamber->neuron[i].setOutputConnections(connections);
+            connections.clear();
+            for(int64_t e = transposed.getOffsets()[i]; e < transposed.getOffsets()[i+1]; e++)
+                connections.push_back(&chamber->neuron[transposed.getTargets()[e]]);
+            chamber->neuron[i].setInputConnections(connections);
+        }
+
+        tmpStr.str("");
+        tmpStr << prefix << nullModelPrefix << k << "_";
+        if(!connectionsFile.empty())
+            saveConnections(tmpStr.str()+connectionsFile);
+        if(!gexfFile.empty())
+            saveGexf(tmpStr.str()+gexfFile);
+        if(!npyPrefix.empty())
+            saveNumpy(tmpStr.str()+npyPrefix);
+        if(!npzFile.empty())
+            saveNumpyArchive(tmpStr.str()+npzFile);
+        if(!matrixMarketFile.empty())
+            saveMatrixMarket(tmpStr.str()+matrixMarketFile);
+    }
+
+    for(size_t i = 0; i < n; i++)
+    {
+        chamber->neuron[i].setOutputConnections(outputs[i]);
+        chamber->neuron[i].setInputConnections(inputs[i]);
+    }
+}
+
+// Sweeps are seeded from the network seed, so the curves are reproducible
+void Network::savePercolation(std::string fileName)
+{
+    Percolation percolation(Adjacency(chamber->neuron));
+    std::vector<int> component;
+
+    std::cout << "Computing percolation curves...\n";
+    percolation.stronglyConnectedComponents(component);
+    percolation.weaklyConnectedComponents(component);
+    percolation.sweep(percolationMode, percolationSweeps, percolationPoints, seed);
+    if(percolation.save(fileName))
+        std::cout << "Percolation curves saved.\n";
+}
+
+// The path sampling uses its own RNG stream so the statistics do not
+// depend on what else is written, nor share draws with the generation
+void Network::saveStatistics(std::string fileName)
+{
+    Statistics statistics(Adjacency(chamber->neuron));
+    gsl_rng* sampler = gsl_rng_alloc(gsl_rng_taus2);
+
+    gsl_rng_set(sampler, Random::streamSeed(seed, 0, STREAM_STATISTICS));
+    std::cout << "Computing statistics...\n";
+    statistics.compute(statisticsMetrics, statisticsPathSamples, sampler);
+    gsl_rng_free(sampler);
+    if(statistics.save(fileName))
+        std::cout << "Statistics saved.\n";
+}
+
+// The counters belong to the whole process, so every network generated so
+// far (e.g. earlier realizations) is included
+void Network::saveProfiler(std::string fileName)
+{
+    if(!Profiler::isEnabled())
+    {
+        std::cout << "Warning! Profiling is disabled in this build, define NEURONGEN_PROFILE in neurongen.pri\n";
+        return;
+    }
+    if(Profiler::save(fileName))
+        std::cout << "Profiling report saved.\n";
+}
+
+void Network::saveHeatmap(std::string prefix)
+{
+    Heatmap* heatmap = chamber->getHeatmap();
+    if(!heatmap)
+        return;
+    if(heatmapPNG ? heatmap->savePNG(prefix) : heatmap->saveNumpy(prefix))
+        std::cout << "Heatmaps saved.\n";
+}
+
+// Coordinate pattern matrix, entry (i, j) means i projects onto j (1-based)
+void Network::saveMatrixMarket(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+    std::stringstream tmpStr;
+    Adjacency adjacency(chamber->neuron);
+    const std::vector<int64_t>& offsets = adjacency.getOffsets();
+    const std::vector<int32_t>& targets = adjacency.getTargets();
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return;
+    }
+
+    savedFile
+        << "%%MatrixMarket matrix coordinate pattern general\n"
+        << "%-----------------------------------------------------------------\n"
+        << "% Neurongen \n"
+        << "% Connection List (row = input, column = output)\n"
+        << "% Seed: " << seed << "\n"
+        << "%-----------------------------------------------------------------\n"
+        << adjacency.getNodeCount() << " " << adjacency.getNodeCount() << " " << adjacency.getEdgeCount() << "\n";
+
+    for(int i = 0; i < adjacency.getNodeCount(); i++)
+    {
+        for(int64_t j = offsets[i]; j < offsets[i+1]; j++)
+            tmpStr << i+1 << " " << targets[j]+1 << "\n";
+        savedFile << tmpStr.str();
+        tmpStr.str("");
+    }
+    savedFile.close();
+    std::cout << "Matrix Market file saved.\n";
+}
+
 void Network::saveAxonalMap(std::string fileName)
 {
     std::ofstream savedFile(fileName.c_str());
@@ -273,6 +953,7 @@ void Network::loadPositionalMap(std::string fileName)
 
     int nCurrent;
     double posX, posY;
+    std::vector<Vector2d> positions;
 
     std::stringstream tmpStr;
     
@@ -291,8 +972,12 @@ void Network::loadPositionalMap(std::string fileName)
         tmpStr.clear();
         tmpStr.str(line);
         tmpStr >> nCurrent >> posX >> posY;
-        chamber->neuron[nCurrent].setPosition(Vector2d(posX, posY));
+        if(nCurrent >= int(positions.size()))
+            positions.resize(nCurrent+1, Vector2d(0., 0.));
+        positions.at(nCurrent) = Vector2d(posX, posY);
     }
+    // Neurons are created here, in place of the placement stage
+    chamber->restoreNeurons(positions);
 }
 
 void Network::saveSizes(std::string fileName)
@@ -670,18 +1355,29 @@ std::vector<double> Network::generateUndirectedKcore()
     return kcoreRatio;
 }
 
-bool Network::seedRNG()
+bool Network::seedRNG(int newSeed)
 {
     std::stringstream tmpStr, seedStr;
 	struct timeval tv;
-	gettimeofday(&tv,NULL);
-    struct tm *tm = localtime(&tv.tv_sec);
-	seed = abs(int(tv.tv_usec/10+tv.tv_sec*100000));	// Creates the seed based on actual time
+    if(newSeed >= 0)
+        seed = newSeed;
+    else
+    {
+        gettimeofday(&tv,NULL);
+        seed = abs(int(tv.tv_usec/10+tv.tv_sec*100000));	// Creates the seed based on actual time
+    }
 	
-    rng = gsl_rng_alloc(gsl_rng_taus2);
+    if(rng && rng->type != Random::engineType(rngEngine))
+    {
+        gsl_rng_free(rng);
+        rng = NULL;
+    }
+    if(!rng)
+        rng = gsl_rng_alloc(Random::engineType(rngEngine));
 	
     gsl_rng_set(rng,seed);			// Seeds the previously created RNG
-    chamber->setRNG(rng);
+    if(chamber)
+        chamber->setRNG(rng);
 /*
     tmpStr << "% Date: " << tm->tm_mday << "/" << tm->tm_mon +1 << "/" << tm->tm_year + 1900 << ", "
            << "Time: " << tm->tm_hour << ":" << tm->tm_min << ":" << tm->tm_sec << ", "
@@ -715,15 +1411,10 @@ bool Network::seedRNG()
 }
 
 
-void Network::loadConfigFile(std::string filename)
+// Returns false if the network could not be generated
+bool Network::loadConfigFile(std::string filename)
 {
-    std::string tmpStr;
-    bool generateNetwork = false;
-    neuron::chamberParameters cparams = neuron::DEFAULT_CHAMBER_PARAMETERS;
-    neuron::cultureParameters cultparams = neuron::DEFAULT_CULTURE_PARAMETERS;
-    neuron::somaParameters somaparams = neuron::DEFAULT_SOMA_PARAMETERS;
-    neuron::dtreeParameters dtreeparams = neuron::DEFAULT_DTREE_PARAMETERS;
-    neuron::axonParameters axonparams = neuron::DEFAULT_AXON_PARAMETERS;
+    Sweep sweep;
 
     configFile = new libconfig::Config();
     try
@@ -735,242 +1426,599 @@ void Network::loadConfigFile(std::string filename)
         std::cout << e.getLine() << " " << e.getError() << "\n";
     }
     configFile->setAutoConvert(true);
+    if(!parseConfig(*configFile))
+        return false;
+
+    // Parameter sweep (optional)
+    if(sweep.load(*configFile))
+    {
+        sweep.run(*configFile, *this);
+        return true;
+    }
+
+    if(!buildChamber())
+        return false;
+    if(surrogateActive)
+    {
+        generateSurrogate();
+        saveOutputs();
+        return true;
+    }
+    if(ensembleActive)
+    {
+        generateEnsemble();
+        return true;
+    }
+
+    // Finally generate the network
+    if(!generate())
+        return false;
+
+    // Save everything
+    saveOutputs();
+    return true;
+}
+
+// Creates the chamber with the current parameters, returns false if its
+// pattern could not be loaded
+bool Network::buildChamber()
+{
+    addChamber(chamberParams);
+    if(!chamber->isValid())
+        return false;
+    setCultureParameters(cultureParams);
+    setNeuronParameters(somaParams, dtreeParams, axonParams);
+    chamber->setProgressCallback(progress, progressData);
+    return true;
+}
+
+// Programmatic counterpart of parseConfig, builds the chamber right away.
+// Returns false if it could not be built
+bool Network::setParameters(const neuron::generationParameters& params)
+{
+    chamberParams = params.chamber;
+    cultureParams = params.culture;
+    somaParams = params.soma;
+    dtreeParams = params.dtree;
+    axonParams = params.axon;
+    fixedSeed = params.seed;
+    return buildChamber();
+}
+
+neuron::generationParameters Network::getParameters()
+{
+    neuron::generationParameters params;
+    params.chamber = chamberParams;
+    params.culture = cultureParams;
+    params.soma = somaParams;
+    params.dtree = dtreeParams;
+    params.axon = axonParams;
+    params.seed = fixedSeed;
+    return params;
+}
+
+void Network::setProgressCallback(neuron::progressCallback callback, void* data)
+{
+    progress = callback;
+    progressData = data;
+    if(chamber)
+        chamber->setProgressCallback(callback, data);
+}
+
+GeneratedNetwork Network::getResult()
+{
+    return GeneratedNetwork(chamber, seed);
+}
+
+// Reads every network parameter from config, returns false if the network
+// should not be generated or a required setting is missing
+bool Network::parseConfig(libconfig::Config& config)
+{
+    std::string tmpStr;
+    bool generateNetwork = false, tmpBool;
+    chamberParams = neuron::DEFAULT_CHAMBER_PARAMETERS;
+    cultureParams = neuron::DEFAULT_CULTURE_PARAMETERS;
+    somaParams = neuron::DEFAULT_SOMA_PARAMETERS;
+    dtreeParams = neuron::DEFAULT_DTREE_PARAMETERS;
+    axonParams = neuron::DEFAULT_AXON_PARAMETERS;
+
     // Start setting the connectivity
-    if(!configFile->lookupValue("network.generation", generateNetwork))
+    if(!config.lookupValue("network.generation", generateNetwork))
     {
         std::cout << "Main error. Network generation variable not set\n";
-        exit(1);
+        return false;
     }
 
     // Generate the network
     if(generateNetwork)
     {
-        if(!configFile->lookupValue("network.pattern.file", tmpStr))
+        if(!config.lookupValue("network.pattern.file", tmpStr))
         {
             std::cout << "Main error. Network pattern file not set\n";
-            exit(1);
+            return false;
         }
         // Assign the pattern
-        cparams.pattern = true;
-        cparams.patternFile = tmpStr;
-        cparams.type = neuron::CH_TYPE_CUSTOM;
-        cparams.units = neuron::UNITS_MILIMETERS; 
-        if(!configFile->lookupValue("network.pattern.width", cparams.width))
+        chamberParams.pattern = true;
+        chamberParams.patternFile = tmpStr;
+        chamberParams.type = neuron::CH_TYPE_CUSTOM;
+        chamberParams.units = neuron::UNITS_MILIMETERS; 
+        if(!config.lookupValue("network.pattern.width", chamberParams.width))
             std::cout << "Warning! Missing network.pattern.width\n";
-        if(!configFile->lookupValue("network.pattern.height", cparams.height))
+        if(!config.lookupValue("network.pattern.height", chamberParams.height))
             std::cout << "Warning! Missing network.pattern.height\n";
         // Check for the density map
-        if(!configFile->lookupValue("network.densityMap.active", cparams.densityMap))
+        if(!config.lookupValue("network.densityMap.active", chamberParams.densityMap))
             std::cout << "Warning! Missing network.densityMap.active. Not using any density map\n";
-        if(cparams.densityMap)
+        if(chamberParams.densityMap)
         {
-          if(!configFile->lookupValue("network.densityMap.file", cparams.densityMapFile))
+          if(!config.lookupValue("network.densityMap.file", chamberParams.densityMapFile))
           {
             std::cout << "Main error. Missing network.densityMap.file\n";
-            exit(1);
+            return false;
           }
-          if(!configFile->lookupValue("network.densityMap.binWidth", cparams.densityMapBinWidth))
+          if(!config.lookupValue("network.densityMap.binWidth", chamberParams.densityMapBinWidth))
           {
             std::cout << "Main error. Missing network.densityMap.binWidth\n";
-            exit(1);
+            return false;
           }
-          if(!configFile->lookupValue("network.densityMap.binHeight", cparams.densityMapBinHeight))
+          if(!config.lookupValue("network.densityMap.binHeight", chamberParams.densityMapBinHeight))
           {
             std::cout << "Main error. Missing network.densityMap.binHeight\n";
-            exit(1);
+            return false;
           }
         }
 
-        // Create the chamber
-        addChamber(cparams);
-        
         // Add neurons
-        if(!configFile->lookupValue("network.neurons", cultparams.neuronNumber))
+        if(!config.lookupValue("network.neurons", cultureParams.neuronNumber))
             std::cout << "Warning! Missing network.neurons\n";
-        setCultureParameters(cultparams);
 
         // Configure neurons PARTIALLY MISSING
         // Configure soma
-        if(!configFile->lookupValue("network.soma.radius", somaparams.radius))
+        if(!config.lookupValue("network.soma.radius", somaParams.radius))
             std::cout << "Warning! Missing network.soma.radius\n";
 
         // Configure dendritic tree
 
-        if(!configFile->lookupValue("network.dendritic_tree.type", tmpStr))
+        if(!config.lookupValue("network.dendritic_tree.type", tmpStr))
             std::cout << "Warning! Missing network.dendritic_tree.type\n";
         if(!tmpStr.compare("homogeneous"))
-                dtreeparams.type = neuron::DTREE_TYPE_HOMOGENEOUS;
+                dtreeParams.type = neuron::DTREE_TYPE_HOMOGENEOUS;
         else
             std::cout << "Warning! Invalid network.dendritic_tree.type\n";
         
-        if(!configFile->lookupValue("network.dendritic_tree.shape", tmpStr))
+        if(!config.lookupValue("network.dendritic_tree.shape", tmpStr))
             std::cout << "Warning! Missing network.dendritic_tree.shape\n";
         if(!tmpStr.compare("circular"))
-                dtreeparams.shape = neuron::DTREE_SHAPE_CIRCULAR;
+                dtreeParams.shape = neuron::DTREE_SHAPE_CIRCULAR;
         else
             std::cout << "Warning! Invalid network.dendritic_tree.shape\n";
 
-        if(!configFile->lookupValue("network.dendritic_tree.radius_distribution", tmpStr))
+        if(!config.lookupValue("network.dendritic_tree.radius_distribution", tmpStr))
             std::cout << "Warning! Missing network.dendritic_tree.radius_distribution\n";
         if(!tmpStr.compare("gaussian"))
-                dtreeparams.sizeDistribution = neuron::DISTRIBUTION_GAUSSIAN;
+                dtreeParams.sizeDistribution = neuron::DISTRIBUTION_GAUSSIAN;
         else
             std::cout << "Warning! Invalid network.dendritic_tree.radius_distribution\n";
  
-        if(!configFile->lookupValue("network.dendritic_tree.radius_mean", dtreeparams.meanRadius))
+        if(!config.lookupValue("network.dendritic_tree.radius_mean", dtreeParams.meanRadius))
             std::cout << "Warning! Missing network.dendritic_tree.radius_mean\n";
-        if(!configFile->lookupValue("network.dendritic_tree.radius_std_dev", dtreeparams.stdRadius))
+        if(!config.lookupValue("network.dendritic_tree.radius_std_dev", dtreeParams.stdRadius))
             std::cout << "Warning! Missing network.dendritic_tree.std_dev\n";
  
         // Configure axons
 
         // Axon type
-        if(!configFile->lookupValue("network.axon.type", tmpStr))
+        if(!config.lookupValue("network.axon.type", tmpStr))
             std::cout << "Warning! Missing network.axon.type\n";
         if(!tmpStr.compare("segmented"))
-                axonparams.type = neuron::AXON_TYPE_SEGMENTED;
+                axonParams.type = neuron::AXON_TYPE_SEGMENTED;
         else
             std::cout << "Warning! Invalid network.axon.type\n";
         // Axon distribution
-        if(!configFile->lookupValue("network.axon.length_distribution", tmpStr))
+        if(!config.lookupValue("network.axon.length_distribution", tmpStr))
             std::cout << "Warning! Missing network.axon.length_distribution\n";
         if(!tmpStr.compare("rayleigh"))
-                axonparams.lengthDistribution = neuron::DISTRIBUTION_RAYLEIGH;
+                axonParams.lengthDistribution = neuron::DISTRIBUTION_RAYLEIGH;
         else
             std::cout << "Warning! Invalid network.axon.length_distribution\n";
 
-        if(!configFile->lookupValue("network.axon.length_mean", axonparams.meanLength))
+        if(!config.lookupValue("network.axon.length_mean", axonParams.meanLength))
             std::cout << "Warning! Missing network.axon.length_mean\n";
         
-        if(!configFile->lookupValue("network.axon.length_std_deviation", axonparams.stdLength))
+        if(!config.lookupValue("network.axon.length_std_deviation", axonParams.stdLength))
             std::cout << "Warning! Missing network.axon.length_std_deviation\n";
         
-        if(!configFile->lookupValue("network.axon.width", axonparams.width))
+        if(!config.lookupValue("network.axon.width", axonParams.width))
             std::cout << "Warning! Missing network.axon.width\n";
 
         // Initial Angle distribution
-        if(!configFile->lookupValue("network.axon.initial_angle_distribution", tmpStr))
+        if(!config.lookupValue("network.axon.initial_angle_distribution", tmpStr))
             std::cout << "Warning! Missing network.axon.initial_angle_distribution\n";
         if(!tmpStr.compare("uniform"))
-            axonparams.initialAngleDistribution = neuron::DISTRIBUTION_UNIFORM;
+            axonParams.initialAngleDistribution = neuron::DISTRIBUTION_UNIFORM;
         else
             std::cout << "Warning! Invalid network.axon.initial_angle_distribution\n";
 
-        if(!configFile->lookupValue("network.axon.initial_angle_mean", axonparams.meanInitialAngle))
+        if(!config.lookupValue("network.axon.initial_angle_mean", axonParams.meanInitialAngle))
             std::cout << "Warning! Missing network.axon.initial_angle_mean\n";
 
-        if(!configFile->lookupValue("network.axon.initial_angle_std_dev", axonparams.stdInitialAngle))
+        if(!config.lookupValue("network.axon.initial_angle_std_dev", axonParams.stdInitialAngle))
             std::cout << "Warning! Missing network.axon.initial_angle_std_dev\n";
 
         // Segment Angle distribution
-        if(!configFile->lookupValue("network.axon.segment_angle_distribution", tmpStr))
+        if(!config.lookupValue("network.axon.segment_angle_distribution", tmpStr))
             std::cout << "Warning! Missing network.axon.segment_angle_distribution\n";
         if(!tmpStr.compare("gaussian"))
-            axonparams.initialAngleDistribution = neuron::DISTRIBUTION_GAUSSIAN;
+            axonParams.initialAngleDistribution = neuron::DISTRIBUTION_GAUSSIAN;
         else
             std::cout << "Warning! Invalid network.axon.segment_angle_distribution\n";
 
-        if(!configFile->lookupValue("network.axon.segment_angle_mean", axonparams.meanSegmentAngle))
+        if(!config.lookupValue("network.axon.segment_angle_mean", axonParams.meanSegmentAngle))
             std::cout << "Warning! Missing network.axon.segment_angle_mean\n";
 
-        if(!configFile->lookupValue("network.axon.segment_angle_std_dev", axonparams.stdSegmentAngle))
+        if(!config.lookupValue("network.axon.segment_angle_std_dev", axonParams.stdSegmentAngle))
             std::cout << "Warning! Missing network.axon.segment_angle_std_dev\n";
 
-        if(!configFile->lookupValue("network.axon.segment_angle_max_std_dev", axonparams.maxStdSegmentAngle))
+        if(!config.lookupValue("network.axon.segment_angle_max_std_dev", axonParams.maxStdSegmentAngle))
             std::cout << "Warning! Missing network.axon.segment_angle_max_std_dev\n";
 
-        if(!configFile->lookupValue("network.axon.segment_length", axonparams.segmentLength))
+        if(!config.lookupValue("network.axon.segment_length", axonParams.segmentLength))
             std::cout << "Warning! Missing network.axon.segment_length\n";
 
-        if(!configFile->lookupValue("network.axon.segment_count", axonparams.segmentCount))
+        if(!config.lookupValue("network.axon.segment_count", axonParams.segmentCount))
             std::cout << "Warning! Missing network.axon.segment_count\n";
 
-        if(!configFile->lookupValue("network.axon.segment_max_retries", axonparams.maxRetries))
+        if(!config.lookupValue("network.axon.segment_max_retries", axonParams.maxRetries))
             std::cout << "Warning! Missing network.axon.segment_max_retries\n";
 
         // Segment type
-        if(!configFile->lookupValue("network.axon.segment_type", tmpStr))
+        if(!config.lookupValue("network.axon.segment_type", tmpStr))
             std::cout << "Warning! Missing network.axon.segment_type\n";
         if(!tmpStr.compare("fixed length"))
-            axonparams.segmentType = neuron::AXON_STYPE_FIXEDLENGTH;
+            axonParams.segmentType = neuron::AXON_STYPE_FIXEDLENGTH;
         else
             std::cout << "Warning! Invalid network.axon.segment_type\n";
          
         // Collision Mode
-        if(!configFile->lookupValue("network.axon.collision_mode", tmpStr))
+        if(!config.lookupValue("network.axon.collision_mode", tmpStr))
             std::cout << "Warning! Missing network.axon.collision_mode\n";
         if(!tmpStr.compare("pattern"))
         {
-            axonparams.collisionFlags = 0;
-            axonparams.collisionFlags = neuron::COL_PATTERN;
+            axonParams.collisionFlags = 0;
+            axonParams.collisionFlags = neuron::COL_PATTERN;
         }
         else
             std::cout << "Warning! Invalid network.axon.collision_mode\n";
 
+        // Growth mode (optional), retry is the original algorithm
+        if(config.lookupValue("network.axon.growth_mode", tmpStr))
+        {
+            if(tmpStr == "retry")
+                axonParams.growthMode = neuron::AXON_GROWTH_RETRY;
+            else if(tmpStr == "steered")
+                axonParams.growthMode = neuron::AXON_GROWTH_STEERED;
+            else if(tmpStr == "analytic")
+                axonParams.growthMode = neuron::AXON_GROWTH_ANALYTIC;
+            else
+                std::cout << "Warning! Invalid network.axon.growth_mode\n";
+        }
+        config.lookupValue("network.axon.steering", axonParams.steering);
+        // Lockstep growth (optional), lanes per batch, 0 grows one by one
+        if(config.lookupValue("network.axon.batch", axonParams.batch) &&
+           (axonParams.batch < 0 || axonParams.batch > AXON_BATCH_MAX))
+        {
+            std::cout << "Warning! Invalid network.axon.batch\n";
+            axonParams.batch = 0;
+        }
+
         
 
         // Configure CUX
-        if(!configFile->lookupValue("network.CUX.active", dtreeparams.CUX))
+        if(!config.lookupValue("network.CUX.active", dtreeParams.CUX))
         {
             std::cout << "Warning! Missing network.CUX.active\n";
-            dtreeparams.CUX = false;
+            dtreeParams.CUX = false;
         }
-        if(dtreeparams.CUX)
+        if(dtreeParams.CUX)
         {
-            dtreeparams.sizeDistribution = neuron::DISTRIBUTION_CUX;
-            if(!configFile->lookupValue("network.CUX.fraction", dtreeparams.CUXfraction))
+            dtreeParams.sizeDistribution = neuron::DISTRIBUTION_CUX;
+            if(!config.lookupValue("network.CUX.fraction", dtreeParams.CUXfraction))
                 std::cout << "Warning! Missing network.CUX.fraction\n";
-            if(!configFile->lookupValue("network.CUX.dendritic_tree_multiplier", dtreeparams.CUXmultiplier))
+            if(!config.lookupValue("network.CUX.dendritic_tree_multiplier", dtreeParams.CUXmultiplier))
                 std::cout << "Warning! Missing network.CUX.dendritic_tree_multiplier\n";
-            if(!configFile->lookupValue("network.CUX.file", CUXfile))
+            if(!config.lookupValue("network.CUX.file", CUXfile))
                 std::cout << "Warning! Missing network.CUX.file\n";
         }
 
-        // Set all the parameters in place
-        setNeuronParameters(somaparams, dtreeparams, axonparams);
         // set the inputs
         
-        if(!configFile->lookupValue("network.input.active", inputActive))
+        if(!config.lookupValue("network.input.active", inputActive))
         {
             std::cout << "Warning! Missing network.input.active\n";
             inputActive = false;
         }
         if(inputActive)
         {
-            if(!configFile->lookupValue("network.input.positions_file", inputPositionsFile))
+            if(!config.lookupValue("network.input.positions_file", inputPositionsFile))
                 std::cout << "Warning! Missing network.input.positions_file\n";
-            if(!configFile->lookupValue("network.input.axons_file", inputAxonsFile))
+            if(!config.lookupValue("network.input.axons_file", inputAxonsFile))
                 std::cout << "Warning! Missing network.input.axons_file\n";
         }
 
-        // Finally generate the network
-        generate();
+        // Stage checkpoints (optional)
+        if(!config.lookupValue("network.checkpoint.active", checkpointActive))
+            checkpointActive = false;
+        if(!config.lookupValue("network.checkpoint.file", checkpointFile))
+            checkpointFile = "network.ckpt";
+
+        // Fixed seed (optional, otherwise based on the current time)
+        if(!config.lookupValue("network.seed", fixedSeed))
+            fixedSeed = -1;
+        // Random engine (optional), gsl reproduces the original results
+        if(config.lookupValue("network.rng", tmpStr) && !Random::parseEngine(tmpStr, rngEngine))
+            std::cout << "Warning! Invalid network.rng\n";
+
+        // Stage cache (optional)
+        if(config.lookupValue("network.cache.active", tmpBool) && tmpBool)
+        {
+            if(!config.lookupValue("network.cache.directory", tmpStr))
+                tmpStr = "cache";
+            cache = StageCache(tmpStr);
+            if(fixedSeed < 0)
+                std::cout << "Warning! network.cache is active without network.seed, cached stages will never be reused\n";
+        }
 
-        // Save everything
-        if(!configFile->lookupValue("network.output.positions", tmpStr))
+        // Output files
+        if(!config.lookupValue("network.output.positions", positionsFile))
             std::cout << "Warning! Missing output.positions - Not saving file\n";
-        else
-            savePositionalMap(tmpStr);
-        if(!configFile->lookupValue("network.output.axons", tmpStr))
+        if(!config.lookupValue("network.output.axons", axonsFile))
             std::cout << "Warning! Missing output.axons - Not saving file\n";
-        else
-            saveAxonalMap(tmpStr);
-        if(!configFile->lookupValue("network.output.connections", tmpStr))
+        if(!config.lookupValue("network.output.connections", connectionsFile))
             std::cout << "Warning! Missing output.connections - Not saving file\n";
-        else
-            saveConnections(tmpStr);
-        if(!configFile->lookupValue("network.output.sizes", tmpStr))
+        if(!config.lookupValue("network.output.sizes", sizesFile))
             std::cout << "Warning! Missing output.sizes - Not saving file\n";
-        else
-            saveSizes(tmpStr);
-        if(!configFile->lookupValue("network.output.gexf", tmpStr))
+        if(!config.lookupValue("network.output.gexf", gexfFile))
             std::cout << "Warning! Missing output.gexf - not saving file\n";
-        else
-            saveGexf(tmpStr);
+        // Binary outputs are optional, no warnings if missing
+        config.lookupValue("network.output.npy_prefix", npyPrefix);
+        config.lookupValue("network.output.npz", npzFile);
+        config.lookupValue("network.output.matrix_market", matrixMarketFile);
+        config.lookupValue("network.output.profiler", profilerFile);
+
+        // Statistics summary (optional)
+        if(config.lookupValue("network.statistics.active", tmpBool) && tmpBool)
+        {
+            if(!config.lookupValue("network.statistics.file", statisticsFile))
+                std::cout << "Warning! Missing network.statistics.file\n";
+            statisticsMetrics = neuron::STATS_ALL;
+            if(config.exists("network.statistics.metrics"))
+            {
+                libconfig::Setting& metrics = config.lookup("network.statistics.metrics");
+                statisticsMetrics = neuron::STATS_DEGREES;
+                for(int i = 0; i < metrics.getLength(); i++)
+                {
+                    tmpStr = (const char*)metrics[i];
+                    if(tmpStr == "degrees")
+                        statisticsMetrics |= neuron::STATS_DEGREES;
+                    else if(tmpStr == "reciprocity")
+                        statisticsMetrics |= neuron::STATS_RECIPROCITY;
+                    else if(tmpStr == "clustering")
+                        statisticsMetrics |= neuron::STATS_CLUSTERING;
+                    else if(tmpStr == "assortativity")
+                        statisticsMetrics |= neuron::STATS_ASSORTATIVITY;
+                    else if(tmpStr == "paths")
+                        statisticsMetrics |= neuron::STATS_PATHS;
+                    else
+                        std::cout << "Warning! Unknown statistics metric: " << tmpStr << "\n";
+                }
+            }
+            config.lookupValue("network.statistics.path_samples", statisticsPathSamples);
+        }
+
+        // Connection probability against distance (optional)
+        if(config.lookupValue("network.connection_profile.active", tmpBool) && tmpBool)
+        {
+            if(!config.lookupValue("network.connection_profile.file", profileFile))
+                std::cout << "Warning! Missing network.connection_profile.file\n";
+            if(!config.lookupValue("network.connection_profile.bin_width", profileBinWidth))
+                std::cout << "Warning! Missing network.connection_profile.bin_width\n";
+            if(!config.lookupValue("network.connection_profile.max_distance", profileMaxDistance))
+                std::cout << "Warning! Missing network.connection_profile.max_distance\n";
+        }
+
+        // Components and percolation curves (optional)
+        if(config.lookupValue("network.percolation.active", tmpBool) && tmpBool)
+        {
+            if(!config.lookupValue("network.percolation.file", percolationFile))
+                std::cout << "Warning! Missing network.percolation.file\n";
+            if(config.lookupValue("network.percolation.mode", tmpStr))
+            {
+                if(tmpStr == "site")
+                    percolationMode = neuron::PERCOLATION_SITE;
+                else if(tmpStr == "bond")
+                    percolationMode = neuron::PERCOLATION_BOND;
+                else
+                    std::cout << "Warning! Invalid network.percolation.mode\n";
+            }
+            config.lookupValue("network.percolation.sweeps", percolationSweeps);
+            config.lookupValue("network.percolation.points", percolationPoints);
+            if(percolationPoints < 2)
+            {
+                std::cout << "Warning! Invalid network.percolation.points\n";
+                return false;
+            }
+        }
+
+        // Spiking dynamics (optional), unset parameters keep their defaults
+        if(config.lookupValue("network.dynamics.active", tmpBool) && tmpBool)
+        {
+            if(!config.lookupValue("network.dynamics.file", rasterFile))
+                std::cout << "Warning! Missing network.dynamics.file\n";
+            if(config.lookupValue("network.dynamics.model", tmpStr))
+            {
+                if(tmpStr == "lif")
+                    dynamicsParams.model = neuron::DYNAMICS_LIF;
+                else if(tmpStr == "izhikevich")
+                    dynamicsParams.model = neuron::DYNAMICS_IZHIKEVICH;
+                else
+                    std::cout << "Warning! Invalid network.dynamics.model\n";
+            }
+            config.lookupValue("network.dynamics.duration", dynamicsParams.duration);
+            config.lookupValue("network.dynamics.dt", dynamicsParams.dt);
+            config.lookupValue("network.dynamics.weight", dynamicsParams.weight);
+            config.lookupValue("network.dynamics.delay", dynamicsParams.delay);
+            config.lookupValue("network.dynamics.velocity", dynamicsParams.velocity);
+            config.lookupValue("network.dynamics.noise_rate", dynamicsParams.noiseRate);
+            config.lookupValue("network.dynamics.noise_amplitude", dynamicsParams.noiseAmplitude);
+            config.lookupValue("network.dynamics.lif.tau", dynamicsParams.tau);
+            config.lookupValue("network.dynamics.lif.rest", dynamicsParams.restPotential);
+            config.lookupValue("network.dynamics.lif.threshold", dynamicsParams.threshold);
+            config.lookupValue("network.dynamics.lif.reset", dynamicsParams.resetPotential);
+            config.lookupValue("network.dynamics.lif.refractory", dynamicsParams.refractory);
+            config.lookupValue("network.dynamics.izhikevich.a", dynamicsParams.a);
+            config.lookupValue("network.dynamics.izhikevich.b", dynamicsParams.b);
+            config.lookupValue("network.dynamics.izhikevich.c", dynamicsParams.c);
+            config.lookupValue("network.dynamics.izhikevich.d", dynamicsParams.d);
+            if(dynamicsParams.dt <= 0)
+            {
+                std::cout << "Warning! Invalid network.dynamics.dt\n";
+                return false;
+            }
+            if(dynamicsParams.duration <= 0)
+            {
+                std::cout << "Warning! Invalid network.dynamics.duration\n";
+                return false;
+            }
+        }
+
+        // Quorum percolation curves (optional)
+        if(config.lookupValue("network.quorum.active", tmpBool) && tmpBool)
+        {
+            if(!config.lookupValue("network.quorum.file", quorumFile))
+                std::cout << "Warning! Missing network.quorum.file\n";
+            if(!config.lookupValue("network.quorum.threshold", quorumThreshold))
+                std::cout << "Warning! Missing network.quorum.threshold\n";
+            config.lookupValue("network.quorum.runs", quorumRuns);
+            config.lookupValue("network.quorum.f_from", quorumFrom);
+            config.lookupValue("network.quorum.f_to", quorumTo);
+            config.lookupValue("network.quorum.f_points", quorumPoints);
+            if(quorumPoints <= 0)
+            {
+                std::cout << "Warning! Invalid network.quorum.f_points\n";
+                return false;
+            }
+        }
+
+        // Randomized versions of the network (optional)
+        if(config.lookupValue("network.null_model.active", tmpBool) && tmpBool)
+        {
+            if(!config.lookupValue("network.null_model.prefix", nullModelPrefix))
+                std::cout << "Warning! Missing network.null_model.prefix\n";
+            if(config.lookupValue("network.null_model.mode", tmpStr))
+            {
+                if(tmpStr == "degree")
+                    nullModelMode = neuron::NULL_MODEL_DEGREE;
+                else if(tmpStr == "distance")
+                    nullModelMode = neuron::NULL_MODEL_DISTANCE;
+                else
+                    std::cout << "Warning! Invalid network.null_model.mode\n";
+            }
+            config.lookupValue("network.null_model.count", nullModelCount);
+            config.lookupValue("network.null_model.swaps_per_edge", nullModelSwaps);
+            config.lookupValue("network.null_model.bin_width", nullModelBinWidth);
+        }
+
+        // Retry heatmaps (optional)
+        if(config.lookupValue("network.heatmap.active", tmpBool) && tmpBool)
+        {
+            if(!config.lookupValue("network.heatmap.prefix", heatmapPrefix))
+                std::cout << "Warning! Missing network.heatmap.prefix\n";
+            if(config.lookupValue("network.heatmap.format", tmpStr))
+            {
+                if(tmpStr == "png")
+                    heatmapPNG = true;
+                else if(tmpStr != "npy")
+                    std::cout << "Warning! Invalid network.heatmap.format\n";
+            }
+            config.lookupValue("network.heatmap.scale", heatmapScale);
+        }
+
+        // Surrogate connectivity (optional)
+        if(config.lookupValue("network.surrogate.active", surrogateActive) && surrogateActive)
+        {
+            if(!config.lookupValue("network.surrogate.calibration_runs", surrogateRuns))
+                std::cout << "Warning! Missing network.surrogate.calibration_runs\n";
+            config.lookupValue("network.surrogate.calibration_neurons", surrogateNeurons);
+            config.lookupValue("network.surrogate.bin_width", surrogateBinWidth);
+            config.lookupValue("network.surrogate.max_distance", surrogateMaxDistance);
+            config.lookupValue("network.surrogate.report", surrogateReport);
+        }
 
-        // Save CUX
-        if(dtreeparams.CUX)
-            saveCUX(CUXfile);
+        // Progress reports (optional), --quiet can't be undone here
+        if(config.lookupValue("network.progress.quiet", tmpBool) && tmpBool)
+            progressQuiet = true;
+        config.lookupValue("network.progress.interval", progressInterval);
+        config.lookupValue("network.progress.stream", progressStreamFile);
+
+        // Ensemble of realizations (optional)
+        if(config.lookupValue("network.ensemble.active", ensembleActive) && ensembleActive)
+        {
+            if(!config.lookupValue("network.ensemble.count", ensembleCount))
+                std::cout << "Warning! Missing network.ensemble.count\n";
+            if(!config.lookupValue("network.ensemble.seed_base", ensembleSeedBase))
+                std::cout << "Warning! Missing network.ensemble.seed_base\n";
+            if(!config.lookupValue("network.ensemble.files", ensembleFiles))
+                std::cout << "Warning! Missing network.ensemble.files\n";
+            else if(!singleIntTemplate(ensembleFiles))
+            {
+                std::cout << "Warning! Invalid network.ensemble.files, it needs a single %d\n";
+                return false;
+            }
+            config.lookupValue("network.ensemble.threads", ensembleThreads);
+        }
     }
+    return generateNetwork;
+}
+
+// Every output file name is prepended with prefix
+void Network::saveOutputs(std::string prefix)
+{
+    if(!positionsFile.empty())
+        savePositionalMap(prefix+positionsFile);
+    if(!axonsFile.empty())
+        saveAxonalMap(prefix+axonsFile);
+    if(!connectionsFile.empty())
+        saveConnections(prefix+connectionsFile);
+    if(!sizesFile.empty())
+        saveSizes(prefix+sizesFile);
+    if(!gexfFile.empty())
+        saveGexf(prefix+gexfFile);
+    if(!npyPrefix.empty())
+        saveNumpy(prefix+npyPrefix);
+    if(!npzFile.empty())
+        saveNumpyArchive(prefix+npzFile);
+    if(!matrixMarketFile.empty())
+        saveMatrixMarket(prefix+matrixMarketFile);
+    if(!statisticsFile.empty())
+        saveStatistics(prefix+statisticsFile);
+    if(!profileFile.empty())
+        saveConnectionProfile(prefix+profileFile);
+    if(!percolationFile.empty())
+        savePercolation(prefix+percolationFile);
+    if(!rasterFile.empty())
+        saveRaster(prefix+rasterFile);
+    if(!quorumFile.empty())
+        saveQuorum(prefix+quorumFile);
+    if(!nullModelPrefix.empty())
+        saveNullModels(prefix);
+    if(!heatmapPrefix.empty())
+        saveHeatmap(prefix+heatmapPrefix);
+
+    // Save CUX
+    if(chamber->getDtreeParameters().CUX)
+        saveCUX(prefix+CUXfile);
+
+    if(!profilerFile.empty())
+        saveProfiler(prefix+profilerFile);
 }
 
@@ -20,18 +20,37 @@
 #include <libconfig.h++>
 #include "neuronnamespace.h"
 #include "chamber.h"
+#include "generatednetwork.h"
+#include "stagecache.h"
+
+class NumpyArchive;
 
 class Network
 {
+    friend class Server;
+    friend class Sweep;
     public:
         Network();
         Network(neuron::chamberParameters p);
+        ~Network();
         void addChamber(neuron::chamberParameters p = neuron::DEFAULT_CHAMBER_PARAMETERS);
         inline void setCultureParameters(neuron::cultureParameters cparam)
-            {chamber->setCultureParameters(cparam);}
+            {cultureParams = cparam; chamber->setCultureParameters(cparam);}
         inline void setNeuronParameters(neuron::somaParameters sparam, neuron::dtreeParameters dparam, neuron::axonParameters aparam)
-            {chamber->setNeuronParameters(sparam, dparam, aparam);}
-        void generate();
+            {somaParams = sparam; dtreeParams = dparam; axonParams = aparam;
+             chamber->setNeuronParameters(sparam, dparam, aparam);}
+        bool generate();
+        void generateEnsemble();
+        void generateSurrogate();
+        void saveOutputs(std::string prefix = "");
+        inline void setResume(bool res)
+            {resume = res;}
+        inline void setQuiet(bool q)
+            {progressQuiet = q;}
+        bool setParameters(const neuron::generationParameters& params);
+        neuron::generationParameters getParameters();
+        void setProgressCallback(neuron::progressCallback callback, void* data);
+        GeneratedNetwork getResult();
         void activateZone(std::vector<float> zone);
         std::vector<double> generateKcore();
         std::vector<double> generateOutputKcore();
@@ -46,19 +65,73 @@ class Network
         void saveSizes(std::string fileName);
         void saveCUX(std::string fileName);
         void saveGexf(std::string fileName);
-        bool seedRNG();
+        void saveNumpy(std::string prefix);
+        void saveNumpyArchive(std::string fileName);
+        bool writeNumpyArchive(NumpyArchive& archive);
+        void saveMatrixMarket(std::string fileName);
+        void saveStatistics(std::string fileName);
+        void saveConnectionProfile(std::string fileName);
+        void savePercolation(std::string fileName);
+        void saveRaster(std::string fileName);
+        void saveQuorum(std::string fileName);
+        void saveNullModels(std::string prefix = "");
+        void saveProfiler(std::string fileName);
+        void saveHeatmap(std::string prefix);
+        bool seedRNG(int newSeed = -1);
 
-        void loadConfigFile(std::string filename);
+        bool loadConfigFile(std::string filename);
+        bool parseConfig(libconfig::Config& config);
+        bool buildChamber();
 
     private:
         void init();
+        void runStage(int stage);
+        Network* createRealization();
+        void computeStageKeys(uint64_t* keys);
         Chamber* chamber;
-        int seed;
+        neuron::chamberParameters chamberParams;
+        neuron::cultureParameters cultureParams;
+        neuron::somaParameters somaParams;
+        neuron::dtreeParameters dtreeParams;
+        neuron::axonParameters axonParams;
+        int seed, fixedSeed, rngEngine;
         gsl_rng* rng;
         libconfig::Config* configFile;
-        bool inputActive;
+        bool inputActive, resume, checkpointActive;
         std::string inputAxonsFile, inputPositionsFile, CUXfile, gexfFile;
-        std::string densityMapFile;
+        std::string positionsFile, axonsFile, connectionsFile, sizesFile;
+        std::string npyPrefix, npzFile, matrixMarketFile, profilerFile;
+        std::string statisticsFile;
+        int statisticsMetrics, statisticsPathSamples;
+        std::string profileFile;
+        double profileBinWidth, profileMaxDistance;
+        std::string percolationFile;
+        int percolationMode, percolationSweeps, percolationPoints;
+        std::string rasterFile;
+        neuron::dynamicsParameters dynamicsParams;
+        std::string quorumFile;
+        int quorumThreshold, quorumRuns, quorumPoints;
+        double quorumFrom, quorumTo;
+        std::string nullModelPrefix;
+        std::string heatmapPrefix;
+        int heatmapScale;
+        bool heatmapPNG;
+        int nullModelMode, nullModelCount;
+        double nullModelSwaps, nullModelBinWidth;
+        bool surrogateActive;
+        int surrogateRuns, surrogateNeurons;
+        double surrogateBinWidth, surrogateMaxDistance;
+        std::string surrogateReport;
+        bool ensembleActive;
+        int ensembleCount, ensembleSeedBase, ensembleThreads;
+        std::string ensembleFiles;
+        std::string densityMapFile, checkpointFile;
+        StageCache cache;
+        neuron::progressCallback progress;
+        void* progressData;
+        bool progressQuiet;
+        double progressInterval;
+        std::string progressStreamFile;
 };
 
 #endif
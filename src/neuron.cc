@@ -14,9 +14,15 @@
  * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
+#include "gsl/gsl_cdf.h"
 #include "neuron.h"
 #include "chamber.h"
 #include "defect.h"
+#include "pattern.h"
+#include "profiler.h"
+#include "progress.h"
+#include "random.h"
 
 Neuron::Neuron()
 {
@@ -48,11 +54,12 @@ Neuron::Neuron(neuron::somaParameters param, neuron::axonParameters aparam, neur
 
 void Neuron::init()
 {
+    CUXactive = false;
     if(rng)
     {
-        cR = gsl_ran_flat(rng, 0., 1.);
-        cB = gsl_ran_flat(rng, 0., 1.);
-        cG = gsl_ran_flat(rng, 0., 1.);
+        cR = Random::flat(rng, 0., 1.);
+        cB = Random::flat(rng, 0., 1.);
+        cG = Random::flat(rng, 0., 1.);
     }
     else
     {
@@ -61,10 +68,16 @@ void Neuron::init()
     }
 }
 
+// Angle intervals by their start
+static bool compareIntervals(const Vector2d& a, const Vector2d& b)
+{
+    return a.x() < b.x();
+}
+
 void Neuron::growAxon()
 {
     int trial, retry;
-    bool success;
+    bool success, collision, clear = false;
     double angle;
     Vector2d newSegment, endPoint;
     std::vector<Vector2d> newSegmentDefectPoints;
@@ -75,7 +88,7 @@ void Neuron::growAxon()
         case neuron::DISTRIBUTION_RAYLEIGH:
         default:
             //axonLength = gsl_ran_rayleigh(rng, axonParams.meanLength);
-            axonLength = gsl_ran_rayleigh(rng, axonParams.stdLength);
+            axonLength = Random::rayleigh(rng, axonParams.stdLength);
             break;
     }
 
@@ -100,9 +113,21 @@ void Neuron::growAxon()
             }
             break;
     }
+    // Steering needs the distance field of the pattern
+    Pattern* pattern = chamber->getPattern();
+    bool steered = axonParams.growthMode == neuron::AXON_GROWTH_STEERED && pattern && pattern->hasDistanceField();
+    bool analytic = axonParams.growthMode == neuron::AXON_GROWTH_ANALYTIC && pattern && pattern->hasDistanceField();
+
     // Real growth starts here
     for(int i = 0; i < axonParams.segmentCount; i++)
     {
+        // One draw among the admissible headings, the tip can only be
+        // enclosed if the soma is, then it grows as usual
+        if(analytic && sampleSegment(i, newSegment))
+        {
+            axonSegments.push_back((i > 0 ? axonSegments.at(i-1) : position)+newSegment);
+            continue;
+        }
         trial = 1;
         retry = 0;
         success = false;
@@ -111,7 +136,7 @@ void Neuron::growAxon()
             // The first segment is trivial
             if(i == 0)
             {
-                angle = gsl_ran_flat(rng, 0., 2.*M_PI);
+                angle = Random::flat(rng, 0., 2.*M_PI);
                 newSegment = Vector2d(cos(angle), sin(angle))*axonParams.segmentLength;
             }
             else
@@ -119,12 +144,12 @@ void Neuron::growAxon()
                 switch(axonParams.segmentAngleDistribution)
                 {
                     case neuron::DISTRIBUTION_UNIFORM:
-                        angle = axonParams.meanSegmentAngle + gsl_ran_flat(rng, -axonParams.stdSegmentAngle, 
+                        angle = axonParams.meanSegmentAngle + Random::flat(rng, -axonParams.stdSegmentAngle, 
                                 axonParams.stdSegmentAngle)*trial;
                         break;
                     case neuron::DISTRIBUTION_GAUSSIAN:
                     default:
-                        angle = axonParams.meanSegmentAngle + gsl_ran_gaussian_ziggurat(rng, axonParams.stdSegmentAngle*trial);
+                        angle = axonParams.meanSegmentAngle + Random::gaussian(rng, axonParams.stdSegmentAngle*trial);
                         break;
                 }
                 // Rotate the new angle respect the last vector
@@ -154,21 +179,38 @@ void Neuron::growAxon()
             else
                 endPoint = position+newSegment;
 
+            // Steering bends the segment away from the pattern, and segments
+            // that can't reach any pattern pixel skip the collision test
+            collision = false;
+            if(steered)
+            {
+                steerSegment(endPoint-newSegment, newSegment);
+                endPoint = (i > 0 ? axonSegments.at(i-1) : position)+newSegment;
+                clear = pattern->getClearance(endPoint-newSegment) > newSegment.norm();
+            }
+
             // Now that we have the new segment check if it collides with anything
-            newSegmentDefectPoints.clear();
-            newSegmentDefectPoints.push_back(endPoint-newSegment);
-            newSegmentDefectPoints.push_back(endPoint);
-            newSegmentDefect =
-            Defect(DEFECT_TYPE_SEGMENT, DEFECT_CLASS_AXON, 0, std::vector<double>(1, axonParams.segmentLength),
-                    newSegmentDefectPoints);
-            if(chamber->checkIntersections(newSegmentDefect) && (axonParams.stdSegmentAngle*trial < 
-                                                                 axonParams.maxStdSegmentAngle))
+            if(!clear)
+            {
+                newSegmentDefectPoints.clear();
+                newSegmentDefectPoints.push_back(endPoint-newSegment);
+                newSegmentDefectPoints.push_back(endPoint);
+                newSegmentDefect =
+                Defect(DEFECT_TYPE_SEGMENT, DEFECT_CLASS_AXON, 0, std::vector<double>(1, axonParams.segmentLength),
+                        newSegmentDefectPoints);
+                collision = chamber->checkIntersections(newSegmentDefect);
+            }
+            if(collision && (axonParams.stdSegmentAngle*trial < axonParams.maxStdSegmentAngle))
             {
                 retry++;
+                chamber->getProgress()->retry();
+                chamber->countHeatmap(HEATMAP_AXON_RETRIES, endPoint);
+                PROFILE_COUNT(PROFILE_AXON_RETRIES);
                 if(retry >= axonParams.maxRetries)
                 {
                     retry = 0;
                     trial++;
+                    PROFILE_COUNT(PROFILE_AXON_TRIALS);
                 }
                 success = false;
             }
@@ -176,6 +218,8 @@ void Neuron::growAxon()
             {
                 success = true;
                 std::cout << "Axon limit reached\n";
+                chamber->countHeatmap(HEATMAP_AXON_LIMITS, endPoint);
+                PROFILE_COUNT(PROFILE_AXON_LIMIT);
             }
             else
                 success = true;
@@ -185,8 +229,173 @@ void Neuron::growAxon()
     }
 }
 
+// Removes part of the component of the segment that points down the
+// distance field, all of it when the closest pattern pixel is at the
+// start (times the steering strength), so the axon slides along the
+// barriers instead of retrying against them. The length is kept
+void Neuron::steerSegment(const Vector2d& start, Vector2d& segment)
+{
+    Pattern* pattern = chamber->getPattern();
+    double length = segment.norm(), clearance, toward, weight;
+    Vector2d gradient, heading;
+
+    clearance = pattern->getClearance(start);
+    if(length == 0 || clearance > length)
+        return;
+    gradient = pattern->getClearanceGradient(start);
+    heading = segment/length;
+    toward = heading.dot(gradient);
+    if(toward >= 0)
+        return;
+    weight = std::min(1., axonParams.steering*(1.-std::max(clearance, 0.)/length));
+    heading -= weight*toward*gradient;
+    if(heading.norm() > 0)
+        segment = heading.normalized()*length;
+}
+
+// Segment i drawn from the turn (or, for the first one, heading)
+// distribution truncated to the headings that reach no pattern pixel.
+// Returns false if there is none
+bool Neuron::sampleSegment(int i, Vector2d& segment)
+{
+    Pattern* pattern = chamber->getPattern();
+    Vector2d start = i > 0 ? axonSegments.at(i-1) : position, previous;
+    double length = axonParams.segmentLength, heading = 0, lo, hi, cut;
+    std::vector<Vector2d> blocked, turns, allowed;
+
+    // Last segment always has a special length
+    if(i == axonParams.segmentCount-1)
+        length = fmod(axonLength, axonParams.segmentLength);
+    if(i > 0)
+    {
+        previous = i > 1 ? axonSegments.at(i-1)-axonSegments.at(i-2) : axonSegments.at(0)-position;
+        heading = atan2(previous.y(), previous.x());
+    }
+
+    if(pattern->getClearance(start) > length)
+        allowed.push_back(Vector2d(-M_PI, M_PI));
+    else
+    {
+        if(!pattern->getBlockedHeadings(start, length, blocked))
+            return false;
+        // Blocked turns relative to the heading, wrapped to [-pi, pi) and
+        // slightly widened against rounding, then merged
+        for(size_t k = 0; k < blocked.size(); k++)
+        {
+            lo = remainder(blocked[k].x()-heading, 2*M_PI)-1e-9;
+            hi = lo+blocked[k].y()-blocked[k].x()+2e-9;
+            if(lo < -M_PI)
+            {
+                turns.push_back(Vector2d(lo+2*M_PI, M_PI));
+                lo = -M_PI;
+            }
+            if(hi > M_PI)
+            {
+                turns.push_back(Vector2d(-M_PI, hi-2*M_PI));
+                hi = M_PI;
+            }
+            turns.push_back(Vector2d(lo, hi));
+        }
+        std::sort(turns.begin(), turns.end(), compareIntervals);
+        cut = -M_PI;
+        for(size_t k = 0; k < turns.size(); k++)
+        {
+            if(turns[k].x() > cut)
+                allowed.push_back(Vector2d(cut, turns[k].x()));
+            cut = std::max(cut, turns[k].y());
+        }
+        if(cut < M_PI)
+            allowed.push_back(Vector2d(cut, M_PI));
+        if(allowed.empty())
+            return false;
+    }
+
+    if(i > 0)
+        heading += sampleTurn(allowed);
+    else
+    {
+        // Uniform heading
+        double total = 0, pick;
+        for(size_t k = 0; k < allowed.size(); k++)
+            total += allowed[k].y()-allowed[k].x();
+        pick = Random::uniform(rng)*total;
+        for(size_t k = 0; k < allowed.size(); k++)
+        {
+            heading = allowed[k].x()+pick;
+            pick -= allowed[k].y()-allowed[k].x();
+            if(pick < 0)
+                break;
+        }
+    }
+    segment = Vector2d(cos(heading), sin(heading))*length;
+    return true;
+}
+
+// Turn angle from the segment angle distribution restricted to the allowed
+// intervals (within [-pi, pi) of the previous heading). If they get no
+// probability, the allowed turn closest to the mean
+double Neuron::sampleTurn(const std::vector<Vector2d>& allowed)
+{
+    double mean = remainder(axonParams.meanSegmentAngle, 2*M_PI), sigma = axonParams.stdSegmentAngle;
+    double total = 0, pick, lo, hi, turn, best = 0, distance = HUGE_VAL;
+    int chosen;
+    std::vector<double> mass(allowed.size(), 0);
+    bool gaussian = axonParams.segmentAngleDistribution != neuron::DISTRIBUTION_UNIFORM;
+
+    for(size_t k = 0; k < allowed.size(); k++)
+    {
+        lo = allowed[k].x()-mean;
+        hi = allowed[k].y()-mean;
+        if(sigma > 0 && gaussian)
+            mass[k] = lo >= 0 ? gsl_cdf_gaussian_Q(lo, sigma)-gsl_cdf_gaussian_Q(hi, sigma)
+                              : gsl_cdf_gaussian_P(hi, sigma)-gsl_cdf_gaussian_P(lo, sigma);
+        else if(sigma > 0)
+            mass[k] = std::max(0., std::min(hi, sigma)-std::max(lo, -sigma));
+        total += mass[k];
+        // Closest allowed turn to the mean
+        if(lo <= 0 && hi >= 0)
+        {
+            best = mean;
+            distance = 0;
+        }
+        else if(std::min(fabs(lo), fabs(hi)) < distance)
+        {
+            distance = std::min(fabs(lo), fabs(hi));
+            best = fabs(lo) < fabs(hi) ? allowed[k].x()+1e-9 : allowed[k].y()-1e-9;
+        }
+    }
+    if(!(total > 1e-300))
+        return best;
+
+    // Interval by probability, the last one with any if rounding runs past
+    pick = Random::uniform(rng)*total;
+    chosen = -1;
+    for(size_t k = 0; k < allowed.size(); k++)
+    {
+        if(mass[k] <= 0)
+            continue;
+        chosen = k;
+        if(pick < mass[k])
+            break;
+        pick -= mass[k];
+    }
+    lo = allowed[chosen].x()-mean;
+    hi = allowed[chosen].y()-mean;
+    if(!gaussian)
+        turn = Random::flat(rng, std::max(lo, -sigma), std::min(hi, sigma));
+    // Inverse CDF on the tail the interval lies in, for accuracy
+    else if(lo >= 0)
+        turn = gsl_cdf_gaussian_Qinv(Random::flat(rng, gsl_cdf_gaussian_Q(hi, sigma), gsl_cdf_gaussian_Q(lo, sigma)), sigma);
+    else
+        turn = gsl_cdf_gaussian_Pinv(Random::flat(rng, gsl_cdf_gaussian_P(lo, sigma), gsl_cdf_gaussian_P(hi, sigma)), sigma);
+    return mean+std::min(std::max(turn, lo), hi);
+}
+
+// Zero for neurons without an axon (e.g. surrogate networks)
 double Neuron::getAxonEndToEndDistance()
 {
+    if(axonSegments.empty())
+        return 0.;
     Vector2d curPos = axonSegments.back()-position;
     return curPos.norm();
 }
@@ -208,11 +417,11 @@ Defect Neuron::growDendrites()
             switch(dtreeParams.sizeDistribution)
             {
                 case neuron::DISTRIBUTION_GAUSSIAN:
-                    dtreeRadius = dtreeParams.meanRadius+gsl_ran_gaussian_ziggurat(rng, dtreeParams.stdRadius);
+                    dtreeRadius = dtreeParams.meanRadius+Random::gaussian(rng, dtreeParams.stdRadius);
                     break;
 
                 case neuron::DISTRIBUTION_CUX:
-                    if(gsl_ran_flat(rng, 0., 1.) <= dtreeParams.CUXfraction)
+                    if(Random::flat(rng, 0., 1.) <= dtreeParams.CUXfraction)
                     {
                         multiplier = dtreeParams.CUXmultiplier;
                         CUXactive = true;
@@ -222,12 +431,12 @@ Defect Neuron::growDendrites()
                         multiplier = 1.;
                         CUXactive = false;
                     }
-                    dtreeRadius = dtreeParams.meanRadius*multiplier+gsl_ran_gaussian_ziggurat(rng, dtreeParams.stdRadius);
+                    dtreeRadius = dtreeParams.meanRadius*multiplier+Random::gaussian(rng, dtreeParams.stdRadius);
                     break;
 
                 case neuron::DISTRIBUTION_RAYLEIGH:
                 default:
-                    dtreeRadius = gsl_ran_rayleigh(rng, dtreeParams.meanRadius);
+                    dtreeRadius = Random::rayleigh(rng, dtreeParams.meanRadius);
                     break;
             }
             break;
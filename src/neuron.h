@@ -75,6 +75,8 @@ class Neuron
         double getAxonEndToEndDistance();
         inline double getDtreeRadius()
             {return dtreeRadius;}
+        inline void setDtreeRadius(double rad)
+            {dtreeRadius = rad;}
         Defect getDendrites();
         inline void setKcoreIndex(int idx)
             {kcoreIndex = idx;}
@@ -83,14 +85,21 @@ class Neuron
         void printPovRayStructure();
         inline void setRNG(gsl_rng* rngp)
             {rng = rngp;}
+        inline gsl_rng* getRNG()
+            {return rng;}
         inline std::vector<Vector2d> getAxonSegments()
             {return axonSegments;}
         inline void setAxon(double alen, std::vector<Vector2d> segs)
             {axonLength = alen; axonSegments = segs;}
         inline bool getCUXactive()
             {return CUXactive;}
+        inline void setCUXactive(bool active)
+            {CUXactive = active;}
 
     private:
+        void steerSegment(const Vector2d& start, Vector2d& segment);
+        bool sampleSegment(int i, Vector2d& segment);
+        double sampleTurn(const std::vector<Vector2d>& allowed);
         neuron::somaParameters somaParams;
         neuron::axonParameters axonParams;
         neuron::dtreeParameters dtreeParams;
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "neurongen.h"
+#include "network.h"
+
+bool neuron::generate(const neuron::generationParameters& params, GeneratedNetwork& result,
+                      neuron::progressCallback callback, void* data)
+{
+    Network network;
+
+    if(!network.setParameters(params))
+        return false;
+    network.setProgressCallback(callback, data);
+    if(!network.generate())
+        return false;
+    result = network.getResult();
+    return true;
+}
+
+bool neuron::loadParameters(std::string fileName, neuron::generationParameters& params)
+{
+    libconfig::Config config;
+    Network network;
+
+    try
+    {
+        config.readFile(fileName.c_str());
+    }
+    catch(libconfig::ParseException e)
+    {
+        std::cout << e.getLine() << " " << e.getError() << "\n";
+        return false;
+    }
+    catch(libconfig::FileIOException e)
+    {
+        std::cout << "There was an error opening file " << fileName << "\n";
+        return false;
+    }
+    config.setAutoConvert(true);
+    if(!network.parseConfig(config))
+        return false;
+    params = network.getParameters();
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _NEURONGEN_H_
+#define _NEURONGEN_H_
+
+// Public interface of the neurongen library. Generates networks in memory
+// so they can be used without going through the output files:
+//
+//     neuron::generationParameters params;
+//     if(!neuron::loadParameters("config.cfg", params))
+//         ...
+//     params.seed = 1234;
+//     GeneratedNetwork net;
+//     if(!neuron::generate(params, net))
+//         ...
+//     const Adjacency& adj = net.getAdjacency();
+//
+// Neither function exits the process, failures are reported on std::cout
+// and through the return value.
+
+#include <string>
+#include "neuronnamespace.h"
+#include "adjacency.h"
+#include "generatednetwork.h"
+
+namespace neuron
+{
+    // Generates a whole network into network. The callback (optional)
+    // receives the progress of every stage. It is called from the progress
+    // reporter thread while a stage runs, and from the calling thread when
+    // the stage ends, so it must not touch thread-affine state (e.g. a GUI
+    // or an interpreter lock) without synchronizing. Returns false if the
+    // chamber could not be built (e.g. the pattern file can not be read)
+    bool generate(const generationParameters& params, GeneratedNetwork& network, progressCallback callback = NULL,
+                  void* data = NULL);
+    // Reads the generation parameters from a config file, returns false
+    // if the file can not be read, has no network to generate or misses a
+    // required setting
+    bool loadParameters(std::string fileName, generationParameters& params);
+}
+
+#endif
+    // _NEURONGEN_H_
+
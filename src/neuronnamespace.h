@@ -31,10 +31,21 @@ namespace neuron
     enum displayLists { DL_CHAMBER = 2005, DL_PATTERN = 2105, DL_NEURONS = 2205};
     enum distribution { DISTRIBUTION_DELTA, DISTRIBUTION_RAYLEIGH, DISTRIBUTION_UNIFORM,
                         DISTRIBUTION_GAUSSIAN, DISTRIBUTION_CUX };
+    // Stages of Network::generate, in execution order
+    enum generationStage { STAGE_NONE, STAGE_PATTERN, STAGE_DENSITY_MAP, STAGE_PLACEMENT, STAGE_AXONS,
+                           STAGE_DENDRITES, STAGE_CONNECTIONS, STAGE_COUNT };
+    const char* const STAGE_NAMES[] = {"none", "pattern", "density map", "placement", "axons",
+                                       "dendrites", "connections"};
+    // Metrics written by the statistics output
+    enum statisticsMetric { STATS_DEGREES = 0x01, STATS_RECIPROCITY = 0x02, STATS_CLUSTERING = 0x04,
+                            STATS_ASSORTATIVITY = 0x08, STATS_PATHS = 0x10, STATS_ALL = 0x1F };
+    enum percolationMode { PERCOLATION_BOND, PERCOLATION_SITE };
+    enum nullModelMode { NULL_MODEL_DEGREE, NULL_MODEL_DISTANCE };
     enum neuronAmountType { NEU_AMOUNT_NUMBER, NEU_AMOUNT_DENSITY };
     enum somaShape { SOMA_SHAPE_CIRCULAR };
     enum axonType { AXON_TYPE_STRAIGHT, AXON_TYPE_SEGMENTED };
     enum axonSegmentType { AXON_STYPE_FIXEDNUMBER, AXON_STYPE_FIXEDLENGTH };
+    enum axonGrowthMode { AXON_GROWTH_RETRY, AXON_GROWTH_STEERED, AXON_GROWTH_ANALYTIC };
     enum dTreeType { DTREE_TYPE_HOMOGENEOUS, DTREE_TYPE_FRACTAL };
     enum dTreeShape { DTREE_SHAPE_CIRCULAR, DTREE_SHAPE_CONICAL };
     enum dTreeSizeDistributionType { DTREE_SIZE_DISTTYPE_DELTA, DTREE_SIZE_DISTTYPE_RAYLEIGH };
@@ -116,11 +127,15 @@ namespace neuron
         double maxStdSegmentAngle;
         int segmentCount, maxRetries, segmentType;
         int collisionMode, collisionFlags;
+        int growthMode;
+        double steering;
+        int batch;
     } axonParameters;
     const axonParameters DEFAULT_AXON_PARAMETERS =
         {AXON_TYPE_SEGMENTED, DISTRIBUTION_RAYLEIGH, DISTRIBUTION_UNIFORM, DISTRIBUTION_GAUSSIAN, UNITS_MILIMETERS,
 //         0.8, 0., 0., 0., 0., 0.1, 0.001, 0.01, 3.2, 20, 10, AXON_STYPE_FIXEDLENGTH, 0, 0x02 & 0x04};
-         0.2, 0., 0., 0., 0., 0.1, 0.001, 0.01, 3.2, 20, 10, AXON_STYPE_FIXEDLENGTH, 0, 0x02 & 0x04};
+         0.2, 0., 0., 0., 0., 0.1, 0.001, 0.01, 3.2, 20, 10, AXON_STYPE_FIXEDLENGTH, 0, 0x02 & 0x04,
+         AXON_GROWTH_RETRY, 1.0, 0};
     typedef struct cultureParameters
     {
         int neuronNumber;
@@ -128,6 +143,50 @@ namespace neuron
     } cultureParameters;
     const cultureParameters DEFAULT_CULTURE_PARAMETERS =
         {50, DISTRIBUTION_UNIFORM};
+
+    enum dynamicsModel { DYNAMICS_LIF, DYNAMICS_IZHIKEVICH };
+    // Spiking dynamics run on the generated network. Times in ms,
+    // potentials in mV, rates in Hz and distances in mm
+    typedef struct dynamicsParameters
+    {
+        int model;
+        double duration, dt;
+        // Every spike adds weight to the potential of its targets after
+        // delay+distance/velocity (velocity 0 means no distance delay)
+        double weight, delay, velocity;
+        // Spontaneous release: Poisson events of noiseAmplitude per neuron
+        double noiseRate, noiseAmplitude;
+        // Leaky integrate and fire
+        double tau, restPotential, threshold, resetPotential, refractory;
+        // Izhikevich
+        double a, b, c, d;
+        int seed;
+    } dynamicsParameters;
+    // Regular spiking Izhikevich neurons and a 20 ms LIF membrane
+    const dynamicsParameters DEFAULT_DYNAMICS_PARAMETERS =
+        {DYNAMICS_IZHIKEVICH, 1000., 0.1, 2., 1., 0., 20., 2., 20., -70., -50., -60., 2.,
+         0.02, 0.2, -65., 8., 0};
+
+    // Everything needed to generate a network without a config file
+    typedef struct generationParameters
+    {
+        chamberParameters chamber;
+        cultureParameters culture;
+        somaParameters soma;
+        dtreeParameters dtree;
+        axonParameters axon;
+        int seed;   // Negative values take the seed from the current time
+    } generationParameters;
+    const generationParameters DEFAULT_GENERATION_PARAMETERS =
+        {DEFAULT_CHAMBER_PARAMETERS, DEFAULT_CULTURE_PARAMETERS, DEFAULT_SOMA_PARAMETERS,
+         DEFAULT_DTREE_PARAMETERS, DEFAULT_AXON_PARAMETERS, -1};
+
+    // Called with the current stage and the number of items (neurons)
+    // processed so far out of total, every progress interval from a
+    // reporter thread and once more with done == total from the thread
+    // running the stage when it ends. In ensemble and sweep mode it is
+    // called from several threads at once
+    typedef void (*progressCallback)(int stage, int done, int total, void* data);
 }
 
 #endif
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include "gsl/gsl_rng.h"
+#include "gsl/gsl_randist.h"
+#include "random.h"
+#include "nullmodel.h"
+
+// Unpaired edges kept while walking the curve in the distance mode
+#define NULL_MODEL_PENDING 16
+
+NullModel::NullModel(const Adjacency& adjacency)
+{
+    nodes = adjacency.getNodeCount();
+    sources = adjacency.getSources();
+    targets = adjacency.getTargets();
+    binWidth = 0;
+}
+
+// Soma positions, only needed by the distance mode
+void NullModel::setPositions(const std::vector<double>& xPos, const std::vector<double>& yPos, double bin)
+{
+    x = xPos;
+    y = yPos;
+    binWidth = bin;
+}
+
+int NullModel::lengthBin(int32_t source, int32_t target) const
+{
+    double dx = x[target]-x[source], dy = y[target]-y[source];
+    return int(sqrt(dx*dx+dy*dy)/binWidth);
+}
+
+// Interleaves the bits of two 16 bit cell coordinates (Z order)
+static uint32_t mortonCode(uint32_t cellX, uint32_t cellY)
+{
+    uint32_t code = 0;
+    for(int bit = 0; bit < 16; bit++)
+        code |= (((cellX >> bit) & 1) << (2*bit)) | (((cellY >> bit) & 1) << (2*bit+1));
+    return code;
+}
+
+// Disjoint pairs of edges for one round, flattened. In the distance mode
+// the edges of each length bin are ordered along a Z curve of their
+// sources on a grid of the bin size, randomly shifted every round, and
+// neighbors in that order are paired. Pairing edges with distant sources
+// would get almost every swap rejected
+void NullModel::pairEdges(int mode, gsl_rng* rng, std::vector<int64_t>& pairs)
+{
+    int64_t edges = targets.size();
+    std::vector<int64_t> order(edges);
+
+    for(int64_t e = 0; e < edges; e++)
+        order[e] = e;
+    gsl_ran_shuffle(rng, &order[0], edges, sizeof(int64_t));
+    pairs.clear();
+    if(mode == neuron::NULL_MODEL_DEGREE)
+    {
+        pairs.assign(order.begin(), order.begin()+edges/2*2);
+        return;
+    }
+
+    std::vector<std::pair<uint64_t, int64_t> > buckets(edges);
+    double shiftX = gsl_rng_uniform(rng)*binWidth, shiftY = gsl_rng_uniform(rng)*binWidth;
+    int64_t first = gsl_rng_uniform_int(rng, 2);
+    #pragma omp parallel for
+    for(int64_t k = 0; k < edges; k++)
+    {
+        int64_t e = order[k];
+        uint32_t cellX = uint32_t(int(floor((x[sources[e]]+shiftX)/binWidth))) & 0xFFFF;
+        uint32_t cellY = uint32_t(int(floor((y[sources[e]]+shiftY)/binWidth))) & 0xFFFF;
+        uint64_t key = (uint64_t(lengthBin(sources[e], targets[e])) << 32) | mortonCode(cellX, cellY);
+        buckets[k] = std::make_pair(key, k);
+    }
+    std::sort(buckets.begin(), buckets.end());
+
+    // Edges of the same source can not be swapped, so each edge is paired
+    // with the closest pending one (in the curve order) of another source
+    std::vector<int64_t> pending;
+    for(int64_t k = first; k < edges; k++)
+    {
+        int64_t e = order[buckets[k].second];
+        bool paired = false;
+        if(k > first && (buckets[k].first >> 32) != (buckets[k-1].first >> 32))
+            pending.clear();
+        for(size_t p = pending.size(); p-- > 0 && !paired;)
+        {
+            if(sources[pending[p]] != sources[e])
+            {
+                pairs.push_back(pending[p]);
+                pairs.push_back(e);
+                pending.erase(pending.begin()+p);
+                paired = true;
+            }
+        }
+        if(!paired)
+        {
+            if(pending.size() == NULL_MODEL_PENDING)
+                pending.erase(pending.begin());
+            pending.push_back(e);
+        }
+    }
+}
+
+// Every round pairs the edges at random and proposes one swap per pair.
+// Proposals are checked in parallel against the edges at the start of the
+// round, and two proposals creating the same connection are both dropped,
+// so no self loops or multiple connections appear. Only the pairing uses
+// the RNG, it draws from stream index of seed. Returns the number of
+// accepted swaps
+int64_t NullModel::rewire(int mode, double swapsPerEdge, int seed, int index)
+{
+    int64_t edges = targets.size();
+    int rounds = int(ceil(2*swapsPerEdge));
+    int64_t accepted = 0;
+    std::vector<uint64_t> keys(edges);
+    std::vector<int64_t> pairs;
+    std::vector<std::pair<uint64_t, int64_t> > created;
+    std::vector<char> valid;
+    gsl_rng* rng;
+
+    if(edges < 2 || (mode == neuron::NULL_MODEL_DISTANCE && (binWidth <= 0 || int(x.size()) != nodes)))
+        return 0;
+    rng = gsl_rng_alloc(gsl_rng_taus2);
+    gsl_rng_set(rng, Random::streamSeed(seed, index, STREAM_NULL_MODEL));
+    for(int r = 0; r < rounds; r++)
+    {
+        pairEdges(mode, rng, pairs);
+        int64_t proposals = pairs.size()/2;
+
+        #pragma omp parallel for
+        for(int64_t e = 0; e < edges; e++)
+            keys[e] = edgeKey(sources[e], targets[e]);
+        std::sort(keys.begin(), keys.end());
+
+        valid.assign(proposals, 0);
+        created.resize(2*proposals);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for(int64_t p = 0; p < proposals; p++)
+        {
+            int64_t e = pairs[2*p], f = pairs[2*p+1];
+            int32_t a = sources[e], b = targets[e], c = sources[f], d = targets[f];
+            bool ok = a != c && b != d && a != d && c != b &&
+                      !std::binary_search(keys.begin(), keys.end(), edgeKey(a, d)) &&
+                      !std::binary_search(keys.begin(), keys.end(), edgeKey(c, b));
+            if(ok && mode == neuron::NULL_MODEL_DISTANCE)
+            {
+                int bin = lengthBin(a, b);
+                ok = lengthBin(a, d) == bin && lengthBin(c, b) == bin;
+            }
+            valid[p] = ok;
+            created[2*p] = std::make_pair(ok ? edgeKey(a, d) : ~uint64_t(0), p);
+            created[2*p+1] = std::make_pair(ok ? edgeKey(c, b) : ~uint64_t(0), p);
+        }
+
+        std::sort(created.begin(), created.end());
+        for(size_t k = 0; k+1 < created.size(); k++)
+        {
+            if(created[k].first == created[k+1].first && created[k].first != ~uint64_t(0))
+            {
+                valid[created[k].second] = 0;
+                valid[created[k+1].second] = 0;
+            }
+        }
+
+        #pragma omp parallel for reduction(+:accepted)
+        for(int64_t p = 0; p < proposals; p++)
+        {
+            if(valid[p])
+            {
+                int64_t e = pairs[2*p], f = pairs[2*p+1];
+                std::swap(targets[e], targets[f]);
+                accepted++;
+            }
+        }
+    }
+    gsl_rng_free(rng);
+    return accepted;
+}
+
+// A swapped connection takes the place of the one it replaced in its row
+Adjacency NullModel::getAdjacency() const
+{
+    return Adjacency(nodes, sources, targets);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _NULLMODEL_H_
+#define _NULLMODEL_H_
+
+#include <vector>
+#include <stdint.h>
+#include "gsl/gsl_rng.h"
+#include "adjacency.h"
+#include "neuronnamespace.h"
+
+// Randomized versions of a network built with double edge swaps
+// (a->b, c->d) => (a->d, c->b), which keep every in and out degree. In the
+// distance mode a swap is only accepted if both new connections fall in
+// the same length bin as the ones they replace, so the histogram of
+// connection lengths is also kept.
+class NullModel
+{
+    public:
+        NullModel(const Adjacency& adjacency);
+        void setPositions(const std::vector<double>& xPos, const std::vector<double>& yPos, double bin);
+        int64_t rewire(int mode, double swapsPerEdge, int seed, int index);
+        Adjacency getAdjacency() const;
+
+    private:
+        inline uint64_t edgeKey(int32_t source, int32_t target) const
+            {return (uint64_t(uint32_t(source)) << 32) | uint32_t(target);}
+        int lengthBin(int32_t source, int32_t target) const;
+        void pairEdges(int mode, gsl_rng* rng, std::vector<int64_t>& pairs);
+
+        int nodes;
+        std::vector<int32_t> sources, targets;
+        std::vector<double> x, y;
+        double binWidth;
+};
+
+#endif
+    // _NULLMODEL_H_
+
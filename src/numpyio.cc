@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "numpyio.h"
+
+// Data inside .npy and .npz files starts at a multiple of this
+#define NUMPY_ALIGNMENT 64
+
+NumpyArray::NumpyArray()
+{
+    data = NULL;
+    dataSize = 0;
+}
+
+NumpyArray::NumpyArray(std::string typ, std::vector<size_t> shp, const void* dat, size_t bytes)
+{
+    descr = typ;
+    shape = shp;
+    data = dat;
+    dataSize = bytes;
+}
+
+// kind is the numpy kind character ('f', 'i', 'u'), size in bytes
+std::string NumpyArray::typeDescriptor(char kind, int size)
+{
+    std::stringstream tmpStr;
+    uint16_t probe = 1;
+    if(size == 1)
+        tmpStr << "|";
+    else if(*(reinterpret_cast<char*>(&probe)) == 1)
+        tmpStr << "<";
+    else
+        tmpStr << ">";
+    tmpStr << kind << size;
+    return tmpStr.str();
+}
+
+// Version 1.0 header, padded so the data that follows is aligned
+std::string NumpyArray::header()
+{
+    std::stringstream dict;
+    std::string head;
+    size_t total;
+
+    dict << "{'descr': '" << descr << "', 'fortran_order': False, 'shape': (";
+    for(std::vector<size_t>::iterator i = shape.begin(); i != shape.end(); i++)
+    {
+        dict << *i;
+        if(shape.size() == 1 || i != shape.end()-1)
+            dict << ",";
+        if(i != shape.end()-1)
+            dict << " ";
+    }
+    dict << "), }";
+
+    // magic (6) + version (2) + header length (2) + dict + '\n'
+    total = 10+dict.str().size()+1;
+    if(total%NUMPY_ALIGNMENT != 0)
+        total += NUMPY_ALIGNMENT-total%NUMPY_ALIGNMENT;
+
+    head = "\x93NUMPY";
+    head += char(1);
+    head += char(0);
+    head += char((total-10) & 0xFF);
+    head += char(((total-10) >> 8) & 0xFF);
+    head += dict.str();
+    head.append(total-head.size()-1, ' ');
+    head += '\n';
+    return head;
+}
+
+bool NumpyFile::save(std::string fileName, NumpyArray array)
+{
+    std::ofstream savedFile(fileName.c_str(), std::ios::out | std::ios::binary);
+    std::string head;
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    head = array.header();
+    savedFile.write(head.data(), head.size());
+    savedFile.write(static_cast<const char*>(array.getData()), array.getDataSize());
+    savedFile.close();
+    return true;
+}
+
+// Lookup table for the zip CRC-32, built once at static initialization so
+// archives can be written from several threads
+typedef struct crcTable
+{
+    uint32_t entry[256];
+    crcTable()
+    {
+        uint32_t c;
+        for(uint32_t n = 0; n < 256; n++)
+        {
+            c = n;
+            for(int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entry[n] = c;
+        }
+    }
+} crcTable;
+static const crcTable CRC_TABLE;
+
+// Standard zip (IEEE 802.3) CRC-32
+uint32_t NumpyFile::crc32(const char* buffer, size_t length, uint32_t crc)
+{
+    crc = ~crc;
+    for(size_t i = 0; i < length; i++)
+        crc = CRC_TABLE.entry[(crc ^ static_cast<unsigned char>(buffer[i])) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+NumpyArchive::NumpyArchive(std::string fileName)
+{
+    archiveName = fileName;
+    archive = NULL;
+    file.open(fileName.c_str(), std::ios::out | std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return;
+    }
+    archive = &file;
+    start = file.tellp();
+}
+
+NumpyArchive::NumpyArchive(std::ostream& stream)
+{
+    archiveName = "stream";
+    archive = &stream;
+    start = stream.tellp();
+}
+
+NumpyArchive::~NumpyArchive()
+{
+    if(archive)
+        close();
+}
+
+// Offsets inside the zip are relative to where the archive started
+uint64_t NumpyArchive::position()
+{
+    return uint64_t(archive->tellp()-start);
+}
+
+void NumpyArchive::writeShort(uint16_t value)
+{
+    char bytes[2] = {char(value & 0xFF), char((value >> 8) & 0xFF)};
+    archive->write(bytes, 2);
+}
+
+void NumpyArchive::writeLong(uint32_t value)
+{
+    char bytes[4] = {char(value & 0xFF), char((value >> 8) & 0xFF),
+                     char((value >> 16) & 0xFF), char((value >> 24) & 0xFF)};
+    archive->write(bytes, 4);
+}
+
+bool NumpyArchive::add(std::string name, NumpyArray array)
+{
+    entry newEntry;
+    std::string head = array.header();
+    uint64_t total = uint64_t(head.size())+array.getDataSize();
+    uint64_t offset;
+    uint16_t padding;
+
+    if(!archive)
+        return false;
+    offset = position();
+    // No zip64 support, members and the archive itself must stay under 4GB
+    if(total+offset >= 0xFFFFFFFFull)
+    {
+        std::cout << "Error. " << archiveName << " would exceed 4GB, use the .npy outputs instead\n";
+        return false;
+    }
+
+    newEntry.name = name+".npy";
+    newEntry.size = uint32_t(total);
+    newEntry.offset = uint32_t(offset);
+    newEntry.crc = NumpyFile::crc32(head.data(), head.size());
+    newEntry.crc = NumpyFile::crc32(static_cast<const char*>(array.getData()), array.getDataSize(), newEntry.crc);
+
+    // Pad the extra field (zipalign style, id 0xD935) so the member data is aligned
+    padding = 4;
+    while((offset+30+newEntry.name.size()+padding)%NUMPY_ALIGNMENT != 0)
+        padding++;
+
+    // Local file header
+    writeLong(0x04034b50);
+    writeShort(20);
+    writeShort(0);
+    writeShort(0);
+    writeShort(0);
+    writeShort(0x21);
+    writeLong(newEntry.crc);
+    writeLong(newEntry.size);
+    writeLong(newEntry.size);
+    writeShort(newEntry.name.size());
+    writeShort(padding);
+    archive->write(newEntry.name.data(), newEntry.name.size());
+    writeShort(0xD935);
+    writeShort(padding-4);
+    archive->write(std::string(padding-4, '\0').data(), padding-4);
+
+    archive->write(head.data(), head.size());
+    archive->write(static_cast<const char*>(array.getData()), array.getDataSize());
+    entries.push_back(newEntry);
+    return true;
+}
+
+bool NumpyArchive::close()
+{
+    uint32_t directoryOffset, directorySize;
+
+    if(!archive)
+        return false;
+    directoryOffset = uint32_t(position());
+    for(std::vector<entry>::iterator i = entries.begin(); i != entries.end(); i++)
+    {
+        writeLong(0x02014b50);
+        writeShort(20);
+        writeShort(20);
+        writeShort(0);
+        writeShort(0);
+        writeShort(0);
+        writeShort(0x21);
+        writeLong(i->crc);
+        writeLong(i->size);
+        writeLong(i->size);
+        writeShort(i->name.size());
+        writeShort(0);
+        writeShort(0);
+        writeShort(0);
+        writeShort(0);
+        writeLong(0);
+        writeLong(i->offset);
+        archive->write(i->name.data(), i->name.size());
+    }
+    directorySize = uint32_t(position())-directoryOffset;
+
+    // End of central directory
+    writeLong(0x06054b50);
+    writeShort(0);
+    writeShort(0);
+    writeShort(entries.size());
+    writeShort(entries.size());
+    writeLong(directorySize);
+    writeLong(directoryOffset);
+    writeShort(0);
+    archive->flush();
+    if(file.is_open())
+        file.close();
+    archive = NULL;
+    return true;
+}
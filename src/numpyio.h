@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _NUMPYIO_H_
+#define _NUMPYIO_H_
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "neuronnamespace.h"
+
+// Binary writers for NumPy .npy files and uncompressed .npz archives.
+// Array data is always aligned to 64 bytes inside the file so that both
+// np.load(mmap_mode='r') and direct mmap of the archive members work.
+class NumpyArray
+{
+    public:
+        NumpyArray();
+        NumpyArray(std::string typ, std::vector<size_t> shp, const void* dat, size_t bytes);
+        static std::string typeDescriptor(char kind, int size);
+        std::string header();
+        inline const void* getData()
+            {return data;}
+        inline size_t getDataSize()
+            {return dataSize;}
+
+    private:
+        std::string descr;
+        std::vector<size_t> shape;
+        const void* data;
+        size_t dataSize;
+};
+
+class NumpyFile
+{
+    public:
+        static bool save(std::string fileName, NumpyArray array);
+        static uint32_t crc32(const char* buffer, size_t length, uint32_t crc = 0);
+};
+
+// Writes every array as a stored (not deflated) member of a zip file,
+// which is what np.savez produces. The archive goes to a file or to any
+// open stream (e.g. a std::stringstream)
+class NumpyArchive
+{
+    public:
+        NumpyArchive(std::string fileName);
+        NumpyArchive(std::ostream& stream);
+        ~NumpyArchive();
+        inline bool isOpen()
+            {return archive != NULL;}
+        bool add(std::string name, NumpyArray array);
+        bool close();
+
+    private:
+        typedef struct entry
+        {
+            std::string name;
+            uint32_t crc, size, offset;
+        } entry;
+        void writeShort(uint16_t value);
+        void writeLong(uint32_t value);
+        uint64_t position();
+
+        std::ofstream file;
+        std::ostream* archive;
+        std::streampos start;
+        std::string archiveName;
+        std::vector<entry> entries;
+};
+
+#endif
+    // _NUMPYIO_H_
+
@@ -15,6 +15,9 @@
  */
 
 //#include <png++/png.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <QImage>
 #include "pattern.h"
 
@@ -36,10 +39,22 @@ Pattern::Pattern(double wSize, double hSize)
     origin.y() = height/2.;
 }
 
+Pattern::~Pattern()
+{
+    if(pattern)
+    {
+        for(size_t i = 0; i < widthCount; i++)
+            delete [] pattern[i];
+        delete [] pattern;
+    }
+    pthread_mutex_destroy(&distanceMutex);
+}
+
 void Pattern::init()
 {
     pattern = NULL;
     drawMode = PATTERN_DRAW_MODE_FILL;
+    pthread_mutex_init(&distanceMutex, NULL);
 
     backgroundColor[0] = backgroundColor[1] = backgroundColor[2] = .9;
 //    backgroundColor[0] = backgroundColor[1] = 0.6;
@@ -47,14 +62,15 @@ void Pattern::init()
 //    patternColor[2] = 0.2;
 }
 
-void Pattern::loadPatternFromFile(std::string file)
+// Returns false if the image can not be read
+bool Pattern::loadPatternFromFile(std::string file)
 {
     //png::image< png::gray_pixel_1 > image(file, png::require_color_space< png::gray_pixel_1 >());
     QImage image = QImage(file.c_str());
     if(image.isNull())
     {
-        std::cout << "Error. Could not load the pattern file: " << file << "\nQuitting...\n";
-        exit(1);
+        std::cout << "Error. Could not load the pattern file: " << file << "\n";
+        return false;
     }
     fileName = file;
 
@@ -86,6 +102,7 @@ void Pattern::loadPatternFromFile(std::string file)
             else
                 pattern[x][y] = false;
         }
+    return true;
 }
 
 void Pattern::createEmptyPattern(size_t wCount, size_t hCount)
@@ -110,3 +127,274 @@ Vector2d Pattern::getPosition(int x, int y)
     return origin+Vector2d(unitSize.x()*x, -unitSize.y()*y);
 }
 
+// Walks the pixels crossed by the segment (Amanatides-Woo traversal), each
+// one is visited once. Pixel (x, y) spans unitSize from getPosition(x, y)
+// towards +x and -y. The parts of the segment outside the pattern are clear
+bool Pattern::lineOfSight(Vector2d from, Vector2d to)
+{
+    if(!pattern)
+        return true;
+    // Grid coordinates, y grows downwards like the pixel rows
+    double x0 = (from.x()-origin.x())/unitSize.x(), y0 = (origin.y()-from.y())/unitSize.y();
+    double x1 = (to.x()-origin.x())/unitSize.x(), y1 = (origin.y()-to.y())/unitSize.y();
+    double dx = x1-x0, dy = y1-y0;
+    int x = int(floor(x0)), y = int(floor(y0));
+    int endX = int(floor(x1)), endY = int(floor(y1));
+    int stepX = dx > 0 ? 1 : -1, stepY = dy > 0 ? 1 : -1;
+    double deltaX = dx != 0 ? fabs(1./dx) : HUGE_VAL, deltaY = dy != 0 ? fabs(1./dy) : HUGE_VAL;
+    double maxX = dx != 0 ? (dx > 0 ? floor(x0)+1-x0 : x0-floor(x0))*deltaX : HUGE_VAL;
+    double maxY = dy != 0 ? (dy > 0 ? floor(y0)+1-y0 : y0-floor(y0))*deltaY : HUGE_VAL;
+    int steps = abs(endX-x)+abs(endY-y);
+
+    for(int i = 0; i <= steps; i++)
+    {
+        if(x >= 0 && y >= 0 && x < int(widthCount) && y < int(heightCount) && pattern[x][y])
+            return false;
+        if(maxX < maxY)
+        {
+            maxX += deltaX;
+            x += stepX;
+        }
+        else
+        {
+            maxY += deltaY;
+            y += stepY;
+        }
+    }
+    return true;
+}
+
+// Squared distance transform of one line (Felzenszwalb and Huttenlocher).
+// f holds squared distances (HUGE_VAL where there is nothing), spacing is
+// the pixel size along the line. Only the finite samples enter the lower
+// envelope of parabolas
+static void distanceTransform(const std::vector<double>& f, double spacing, std::vector<double>& d,
+                              std::vector<int>& v, std::vector<double>& z)
+{
+    int n = f.size(), k = -1;
+    double s, w2 = spacing*spacing;
+
+    for(int q = 0; q < n; q++)
+    {
+        if(f[q] == HUGE_VAL)
+            continue;
+        if(k < 0)
+        {
+            k = 0;
+            v[0] = q;
+            z[0] = -HUGE_VAL;
+            z[1] = HUGE_VAL;
+            continue;
+        }
+        s = ((f[q]+w2*q*q)-(f[v[k]]+w2*double(v[k])*v[k]))/(2*w2*(q-v[k]));
+        while(s <= z[k])
+        {
+            k--;
+            s = ((f[q]+w2*q*q)-(f[v[k]]+w2*double(v[k])*v[k]))/(2*w2*(q-v[k]));
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k+1] = HUGE_VAL;
+    }
+    if(k < 0)
+    {
+        d.assign(n, HUGE_VAL);
+        return;
+    }
+    k = 0;
+    for(int q = 0; q < n; q++)
+    {
+        while(z[k+1] < q)
+            k++;
+        d[q] = w2*double(q-v[k])*(q-v[k])+f[v[k]];
+    }
+}
+
+// Exact Euclidean distance transform on the torus (the lattice is
+// periodic, the pattern repeats every width and height), columns first and
+// then rows. Each line is transformed three times over, so the middle copy
+// sees the closest image of every pixel. Safe to call from several
+// realizations at once
+void Pattern::buildDistanceField()
+{
+    std::vector<double> f, d, z;
+    std::vector<int> v;
+    std::vector<double> columns;
+    std::vector<float> field;
+    size_t w = widthCount, h = heightCount, n = 3*std::max(w, h);
+
+    pthread_mutex_lock(&distanceMutex);
+    if(!distance.empty() || !pattern)
+    {
+        pthread_mutex_unlock(&distanceMutex);
+        return;
+    }
+    v.resize(n);
+    z.resize(n+1);
+    columns.resize(w*h);
+
+    f.resize(3*h);
+    d.resize(3*h);
+    for(size_t x = 0; x < w; x++)
+    {
+        for(size_t y = 0; y < 3*h; y++)
+            f[y] = pattern[x][y%h] ? 0 : HUGE_VAL;
+        distanceTransform(f, unitSize.y(), d, v, z);
+        std::copy(d.begin()+h, d.begin()+2*h, columns.begin()+x*h);
+    }
+
+    f.resize(3*w);
+    d.resize(3*w);
+    field.resize(w*h);
+    for(size_t y = 0; y < h; y++)
+    {
+        for(size_t x = 0; x < 3*w; x++)
+            f[x] = columns[(x%w)*h+y];
+        distanceTransform(f, unitSize.x(), d, v, z);
+        for(size_t x = 0; x < w; x++)
+            field[x*h+y] = float(sqrt(d[x+w]));
+    }
+    distance.swap(field);
+    pthread_mutex_unlock(&distanceMutex);
+}
+
+// Pixel of the periodic image of the point inside the pattern rectangle
+void Pattern::getWrappedPixel(const Vector2d& p, int& x, int& y)
+{
+    x = int(floor((p.x()-origin.x())/unitSize.x())) % int(widthCount);
+    y = int(floor((origin.y()-p.y())/unitSize.y())) % int(heightCount);
+    x += x < 0 ? int(widthCount) : 0;
+    y += y < 0 ? int(heightCount) : 0;
+}
+
+// Lower bound of the distance from p to any pattern pixel or periodic
+// image of one. p and the pixels are within half a diagonal of their
+// centers, and the field holds the distances between centers on the torus
+double Pattern::getClearance(const Vector2d& p)
+{
+    int x, y;
+    getWrappedPixel(p, x, y);
+    return distance[size_t(x)*heightCount+y]-unitSize.norm()*(1.+1e-4);
+}
+
+// getClearance of count points at once, written branch free so the
+// index arithmetic vectorizes and only the lookups are gathered
+void Pattern::getClearances(const double* x, const double* y, int count, double* clearance)
+{
+    const float* field = &distance[0];
+    double margin = unitSize.norm()*(1.+1e-4);
+    double ox = origin.x(), oy = origin.y(), ux = unitSize.x(), uy = unitSize.y();
+    int w = int(widthCount), h = int(heightCount);
+
+    #pragma omp simd
+    for(int i = 0; i < count; i++)
+    {
+        int px = int(floor((x[i]-ox)/ux))%w, py = int(floor((oy-y[i])/uy))%h;
+        px += px < 0 ? w : 0;
+        py += py < 0 ? h : 0;
+        clearance[i] = field[size_t(px)*heightCount+py]-margin;
+    }
+}
+
+// Unit vector along which the distance to the pattern grows (zero if there
+// is no pattern or on a ridge)
+Vector2d Pattern::getClearanceGradient(const Vector2d& p)
+{
+    int x, y, x0, x1, y0, y1;
+    Vector2d gradient;
+
+    // Central differences, the neighbours wrap around like the field
+    getWrappedPixel(p, x, y);
+    x0 = (x+int(widthCount)-1)%int(widthCount);
+    x1 = (x+1)%int(widthCount);
+    y0 = (y+int(heightCount)-1)%int(heightCount);
+    y1 = (y+1)%int(heightCount);
+    gradient.x() = widthCount > 1 ? (distance[size_t(x1)*heightCount+y]-distance[size_t(x0)*heightCount+y])
+                                    /(2*unitSize.x()) : 0;
+    // Pixel rows grow downwards
+    gradient.y() = heightCount > 1 ? -(distance[size_t(x)*heightCount+y1]-distance[size_t(x)*heightCount+y0])
+                                     /(2*unitSize.y()) : 0;
+    if(!std::isfinite(gradient.x()) || !std::isfinite(gradient.y()) || gradient.norm() == 0)
+        return Vector2d(0, 0);
+    return gradient.normalized();
+}
+
+// Headings (as [from, to] angle intervals, to-from < pi) along which a
+// segment of the given length from start touches a pattern pixel. For
+// each pixel it is the angular span of the part of the pixel inside the
+// circle of radius length, whose extremes are its corners inside the
+// circle or the crossings of its edges with the circle. The pattern is
+// periodic, pixel indices outside the rectangle are those of the images.
+// Returns false if start is inside a pattern pixel
+bool Pattern::getBlockedHeadings(const Vector2d& start, double length, std::vector<Vector2d>& blocked)
+{
+    int xmin, xmax, ymin, ymax, px, py;
+    Vector2d corner[4], center, a, d, point;
+    double reference, angle, low, high, b, c, disc, t;
+    bool found;
+
+    blocked.clear();
+    xmin = int(floor((start.x()-length-origin.x())/unitSize.x()));
+    xmax = int(floor((start.x()+length-origin.x())/unitSize.x()));
+    ymin = int(floor((origin.y()-start.y()-length)/unitSize.y()));
+    ymax = int(floor((origin.y()-start.y()+length)/unitSize.y()));
+    for(int x = xmin; x <= xmax; x++)
+    {
+        px = x%int(widthCount);
+        px += px < 0 ? int(widthCount) : 0;
+        for(int y = ymin; y <= ymax; y++)
+        {
+            py = y%int(heightCount);
+            py += py < 0 ? int(heightCount) : 0;
+            if(!pattern[px][py])
+                continue;
+            corner[0] = getPosition(x, y);
+            corner[1] = corner[0]+Vector2d(unitSize.x(), 0);
+            corner[2] = corner[0]+Vector2d(unitSize.x(), -unitSize.y());
+            corner[3] = corner[0]-Vector2d(0, unitSize.y());
+            if(start.x() >= corner[0].x() && start.x() <= corner[1].x() &&
+               start.y() <= corner[0].y() && start.y() >= corner[3].y())
+                return false;
+
+            center = corner[0]+Vector2d(unitSize.x(), -unitSize.y())/2.;
+            reference = atan2(center.y()-start.y(), center.x()-start.x());
+            low = M_PI;
+            high = -M_PI;
+            found = false;
+            for(int k = 0; k < 4; k++)
+            {
+                // Corner inside the circle
+                a = corner[k]-start;
+                if(a.norm() <= length)
+                {
+                    angle = remainder(atan2(a.y(), a.x())-reference, 2*M_PI);
+                    low = std::min(low, angle);
+                    high = std::max(high, angle);
+                    found = true;
+                }
+                // Crossings of the edge with the circle, |a+t*d| = length
+                d = corner[(k+1)%4]-corner[k];
+                b = a.dot(d)/d.squaredNorm();
+                c = (a.squaredNorm()-length*length)/d.squaredNorm();
+                disc = b*b-c;
+                if(disc < 0)
+                    continue;
+                for(int sign = -1; sign <= 1; sign += 2)
+                {
+                    t = -b+sign*sqrt(disc);
+                    if(t < 0 || t > 1)
+                        continue;
+                    point = a+t*d;
+                    angle = remainder(atan2(point.y(), point.x())-reference, 2*M_PI);
+                    low = std::min(low, angle);
+                    high = std::max(high, angle);
+                    found = true;
+                }
+            }
+            if(found)
+                blocked.push_back(Vector2d(reference+low, reference+high));
+        }
+    }
+    return true;
+}
@@ -17,6 +17,8 @@
 #ifndef _PATTERN_H_
 #define _PATTERN_H_
 
+#include <vector>
+#include <pthread.h>
 #include <Eigen/Core>
 #include "neuronnamespace.h"
 
@@ -31,8 +33,9 @@ class Pattern
     public:
         Pattern(double x, double y, double wSize, double hSize);
         Pattern(double wSize, double hSize);
+        ~Pattern();
 
-        void loadPatternFromFile(std::string file);
+        bool loadPatternFromFile(std::string file);
         void createEmptyPattern(size_t wCount, size_t hCount);
 
         inline Vector2d getOrigin()
@@ -46,11 +49,20 @@ class Pattern
         inline Vector2i getSizeCount()
             {return Vector2i(int(widthCount), int(heightCount));}
         Vector2d getPosition(int x, int y);
+        bool lineOfSight(Vector2d from, Vector2d to);
+        void buildDistanceField();
+        inline bool hasDistanceField()
+            {return !distance.empty();}
+        double getClearance(const Vector2d& p);
+        void getClearances(const double* x, const double* y, int count, double* clearance);
+        Vector2d getClearanceGradient(const Vector2d& p);
+        bool getBlockedHeadings(const Vector2d& start, double length, std::vector<Vector2d>& blocked);
         inline bool** getPattern()
             {return pattern;}
 
     private:
         void init();
+        void getWrappedPixel(const Vector2d& p, int& x, int& y);
         int drawMode;
 
         bool **pattern;
@@ -59,6 +71,11 @@ class Pattern
         double width, height;
         std::string fileName;
         float backgroundColor[3], patternColor[3];
+        // Distance (mm) from every pixel center to the closest pattern pixel
+        // center or periodic image of one, x*heightCount+y. Built once,
+        // realizations share it
+        std::vector<float> distance;
+        pthread_mutex_t distanceMutex;
 };
 
 #endif
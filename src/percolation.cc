@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "gsl/gsl_rng.h"
+#include "gsl/gsl_randist.h"
+#include "random.h"
+#include "percolation.h"
+
+// Union-find root with path halving
+static int findRoot(std::vector<int>& parent, int i)
+{
+    while(parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// Union by size, returns the size of the merged cluster
+static int joinClusters(std::vector<int>& parent, std::vector<int>& size, int a, int b)
+{
+    a = findRoot(parent, a);
+    b = findRoot(parent, b);
+    if(a == b)
+        return size[a];
+    if(size[a] < size[b])
+        std::swap(a, b);
+    parent[b] = a;
+    size[a] += size[b];
+    return size[a];
+}
+
+Percolation::Percolation(const Adjacency& adjacency)
+{
+    output = adjacency;
+    undirected = adjacency.symmetrize();
+    strongCount = strongGiant = weakCount = weakGiant = 0;
+    sweepMode = neuron::PERCOLATION_BOND;
+    sweepCount = 0;
+}
+
+// Iterative Tarjan. component[i] gets the index of the strongly connected
+// component of neuron i, returns the number of components
+int Percolation::stronglyConnectedComponents(std::vector<int>& component)
+{
+    const std::vector<int64_t>& offsets = output.getOffsets();
+    const std::vector<int32_t>& targets = output.getTargets();
+    int nodes = output.getNodeCount();
+    std::vector<int> index(nodes, -1), lowlink(nodes, 0);
+    std::vector<char> onStack(nodes, 0);
+    std::vector<int> stack;
+    // Call stack of the depth first search: node and next edge to visit
+    std::vector<std::pair<int, int64_t> > calls;
+    int counter = 0, count = 0;
+
+    component.assign(nodes, -1);
+    for(int root = 0; root < nodes; root++)
+    {
+        if(index[root] >= 0)
+            continue;
+        calls.push_back(std::make_pair(root, offsets[root]));
+        index[root] = lowlink[root] = counter++;
+        stack.push_back(root);
+        onStack[root] = 1;
+        while(!calls.empty())
+        {
+            int v = calls.back().first;
+            int64_t& e = calls.back().second;
+            if(e < offsets[v+1])
+            {
+                int w = targets[e++];
+                if(index[w] < 0)
+                {
+                    index[w] = lowlink[w] = counter++;
+                    stack.push_back(w);
+                    onStack[w] = 1;
+                    calls.push_back(std::make_pair(w, offsets[w]));
+                }
+                else if(onStack[w])
+                    lowlink[v] = std::min(lowlink[v], index[w]);
+                continue;
+            }
+            // v is finished
+            if(lowlink[v] == index[v])
+            {
+                int w;
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
+                    onStack[w] = 0;
+                    component[w] = count;
+                } while(w != v);
+                count++;
+            }
+            calls.pop_back();
+            if(!calls.empty())
+            {
+                int parent = calls.back().first;
+                lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
+            }
+        }
+    }
+    strongCount = count;
+    strongGiant = largestComponent(component, count);
+    return count;
+}
+
+int Percolation::weaklyConnectedComponents(std::vector<int>& component)
+{
+    const std::vector<int64_t>& offsets = undirected.getOffsets();
+    const std::vector<int32_t>& targets = undirected.getTargets();
+    int nodes = undirected.getNodeCount();
+    std::vector<int> parent(nodes), size(nodes, 1), label(nodes, -1);
+    int count = 0;
+
+    for(int i = 0; i < nodes; i++)
+        parent[i] = i;
+    for(int i = 0; i < nodes; i++)
+        for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+            if(targets[e] > i)
+                joinClusters(parent, size, i, targets[e]);
+
+    component.assign(nodes, -1);
+    for(int i = 0; i < nodes; i++)
+    {
+        int root = findRoot(parent, i);
+        if(label[root] < 0)
+            label[root] = count++;
+        component[i] = label[root];
+    }
+    weakCount = count;
+    weakGiant = largestComponent(component, count);
+    return count;
+}
+
+int Percolation::largestComponent(const std::vector<int>& component, int count)
+{
+    std::vector<int> size(count, 0);
+    for(std::vector<int>::const_iterator i = component.begin(); i != component.end(); i++)
+        size[*i]++;
+    return count > 0 ? *std::max_element(size.begin(), size.end()) : 0;
+}
+
+// Runs sweeps independent Newman-Ziff sweeps in parallel and keeps the
+// mean and deviation of the giant component fraction at points+1 evenly
+// spaced occupation fractions. Sweep r draws from stream r of seed
+void Percolation::sweep(int mode, int sweeps, int points, int seed)
+{
+    std::vector<double> sum(points+1, 0), sumSquares(points+1, 0);
+
+    sweepMode = mode;
+    sweepCount = sweeps;
+    #pragma omp parallel
+    {
+        std::vector<double> curve(points+1), localSum(points+1, 0), localSquares(points+1, 0);
+
+        #pragma omp for schedule(dynamic)
+        for(int r = 0; r < sweeps; r++)
+        {
+            sweepOnce(mode, Random::streamSeed(seed, r, STREAM_PERCOLATION), curve);
+            for(int k = 0; k <= points; k++)
+            {
+                localSum[k] += curve[k];
+                localSquares[k] += curve[k]*curve[k];
+            }
+        }
+
+        #pragma omp critical
+        for(int k = 0; k <= points; k++)
+        {
+            sum[k] += localSum[k];
+            sumSquares[k] += localSquares[k];
+        }
+    }
+
+    occupation.resize(points+1);
+    giantMean.resize(points+1);
+    giantStd.resize(points+1);
+    for(int k = 0; k <= points; k++)
+    {
+        occupation[k] = double(k)/points;
+        giantMean[k] = sweeps > 0 ? sum[k]/sweeps : 0;
+        giantStd[k] = sweeps > 0 ? sqrt(std::max(0.0, sumSquares[k]/sweeps-giantMean[k]*giantMean[k])) : 0;
+    }
+}
+
+// curve[k] is the giant fraction once a fraction k/points of the edges
+// (bond) or neurons (site) is occupied
+void Percolation::sweepOnce(int mode, uint64_t sweepSeed, std::vector<double>& curve)
+{
+    const std::vector<int64_t>& offsets = undirected.getOffsets();
+    const std::vector<int32_t>& targets = undirected.getTargets();
+    int nodes = undirected.getNodeCount();
+    int points = curve.size()-1;
+    std::vector<int> parent(nodes), size(nodes, 1);
+    std::vector<char> occupied;
+    std::vector<int32_t> order;
+    int giant, next = 1;
+    int64_t total;
+    gsl_rng* rng = gsl_rng_alloc(gsl_rng_taus2);
+
+    gsl_rng_set(rng, sweepSeed);
+    for(int i = 0; i < nodes; i++)
+        parent[i] = i;
+
+    if(mode == neuron::PERCOLATION_SITE)
+    {
+        order.resize(nodes);
+        for(int i = 0; i < nodes; i++)
+            order[i] = i;
+        occupied.assign(nodes, 0);
+        giant = 0;
+    }
+    else
+    {
+        // Each undirected edge once, stored as the position of i < j
+        for(int i = 0; i < nodes; i++)
+            for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+                if(targets[e] > i)
+                {
+                    order.push_back(i);
+                    order.push_back(targets[e]);
+                }
+        giant = nodes > 0 ? 1 : 0;
+    }
+    total = mode == neuron::PERCOLATION_SITE ? nodes : int64_t(order.size()/2);
+    if(total > 0)
+    {
+        if(mode == neuron::PERCOLATION_SITE)
+            gsl_ran_shuffle(rng, &order[0], order.size(), sizeof(int32_t));
+        else
+            gsl_ran_shuffle(rng, &order[0], total, 2*sizeof(int32_t));
+    }
+    curve[0] = nodes > 0 ? double(giant)/nodes : 0;
+
+    for(int64_t t = 1; t <= total; t++)
+    {
+        if(mode == neuron::PERCOLATION_SITE)
+        {
+            int i = order[t-1];
+            occupied[i] = 1;
+            giant = std::max(giant, 1);
+            for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+                if(occupied[targets[e]])
+                    giant = std::max(giant, joinClusters(parent, size, i, targets[e]));
+        }
+        else
+            giant = std::max(giant, joinClusters(parent, size, order[2*(t-1)], order[2*(t-1)+1]));
+
+        // Record every grid point reached by this occupation
+        while(next <= points && int64_t(floor(double(next)*total/points+0.5)) <= t)
+            curve[next++] = double(giant)/nodes;
+    }
+    while(next <= points)
+        curve[next++] = nodes > 0 ? double(giant)/nodes : 0;
+    gsl_rng_free(rng);
+}
+
+bool Percolation::save(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    savedFile.precision(10);
+    savedFile << "% Connected components\n";
+    savedFile << "% strong_components " << strongCount << " strong_giant " << strongGiant << "\n";
+    savedFile << "% weak_components " << weakCount << " weak_giant " << weakGiant << "\n";
+    savedFile << "% Newman-Ziff " << (sweepMode == neuron::PERCOLATION_SITE ? "site" : "bond")
+              << " percolation, " << sweepCount << " sweeps\n";
+    savedFile << "% occupation giant_fraction_mean giant_fraction_std\n";
+    for(size_t k = 0; k < occupation.size(); k++)
+        savedFile << occupation[k] << " " << giantMean[k] << " " << giantStd[k] << "\n";
+    savedFile.close();
+    return true;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _PERCOLATION_H_
+#define _PERCOLATION_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "adjacency.h"
+#include "neuronnamespace.h"
+
+// Connected components and percolation curves of a network. Components
+// are computed without recursion, so they work on any network size. The
+// Newman-Ziff sweeps occupy the edges (bond) or neurons (site) of the
+// undirected network one at a time in random order, tracking the giant
+// component with a union-find, so each sweep gives the whole curve in
+// O(E alpha(N)).
+class Percolation
+{
+    public:
+        Percolation(const Adjacency& adjacency);
+        int stronglyConnectedComponents(std::vector<int>& component);
+        int weaklyConnectedComponents(std::vector<int>& component);
+        static int largestComponent(const std::vector<int>& component, int count);
+        void sweep(int mode, int sweeps, int points, int seed);
+        bool save(std::string fileName);
+
+    private:
+        void sweepOnce(int mode, uint64_t sweepSeed, std::vector<double>& curve);
+
+        Adjacency output, undirected;
+        int strongCount, strongGiant, weakCount, weakGiant;
+        int sweepMode, sweepCount;
+        std::vector<double> occupation, giantMean, giantStd;
+};
+
+#endif
+    // _PERCOLATION_H_
+
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include "profiler.h"
+
+static const char* const COUNTER_NAMES[] = {"placement_retries", "placement_retry_limit", "axon_retries",
+                                             "axon_trial_escalations", "axon_limit_reached", "range_queries",
+                                             "range_candidates"};
+static const char* const DEFECT_TYPE_NAMES[] = {"disk", "rectangle", "chain", "pixel", "segment"};
+
+// Blocks of every thread that counted something, never freed so the
+// counts of finished threads are kept
+static std::vector<profileBlock*> blocks;
+static pthread_mutex_t blocksMutex = PTHREAD_MUTEX_INITIALIZER;
+
+__thread profileBlock* Profiler::local = NULL;
+
+profileBlock* Profiler::registerThread()
+{
+    local = new profileBlock;
+    memset(local, 0, sizeof(profileBlock));
+    pthread_mutex_lock(&blocksMutex);
+    blocks.push_back(local);
+    pthread_mutex_unlock(&blocksMutex);
+    return local;
+}
+
+void Profiler::addStage(int stage, double wall, double cpu)
+{
+    profileBlock* block = localBlock();
+    block->stageRuns[stage]++;
+    block->stageWall[stage] += wall;
+    block->stageCPU[stage] += cpu;
+}
+
+bool Profiler::isEnabled()
+{
+#ifdef NEURONGEN_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Profiler::reset()
+{
+    pthread_mutex_lock(&blocksMutex);
+    for(std::vector<profileBlock*>::iterator i = blocks.begin(); i != blocks.end(); i++)
+        memset(*i, 0, sizeof(profileBlock));
+    pthread_mutex_unlock(&blocksMutex);
+}
+
+double Profiler::wallTime()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec+tv.tv_usec*1e-6;
+}
+
+double Profiler::cpuTime()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec+usage.ru_utime.tv_usec*1e-6+usage.ru_stime.tv_sec+usage.ru_stime.tv_usec*1e-6;
+}
+
+// Counters added up over all the threads. Stages run several times (e.g.
+// ensembles or sweeps) report the total time and the number of runs
+bool Profiler::save(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+    profileBlock total;
+    struct rusage usage;
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    memset(&total, 0, sizeof(profileBlock));
+    pthread_mutex_lock(&blocksMutex);
+    for(std::vector<profileBlock*>::iterator i = blocks.begin(); i != blocks.end(); i++)
+    {
+        for(int k = 0; k < PROFILE_COUNTERS; k++)
+            total.counters[k] += (*i)->counters[k];
+        for(int k = 0; k < neuron::STAGE_COUNT; k++)
+        {
+            total.stageRuns[k] += (*i)->stageRuns[k];
+            total.stageWall[k] += (*i)->stageWall[k];
+            total.stageCPU[k] += (*i)->stageCPU[k];
+        }
+    }
+    savedFile << "{\n  \"threads\": " << blocks.size() << ",\n";
+    pthread_mutex_unlock(&blocksMutex);
+    getrusage(RUSAGE_SELF, &usage);
+
+    // ru_maxrss is in kilobytes on Linux
+    savedFile << "  \"peak_rss_kb\": " << usage.ru_maxrss << ",\n";
+    savedFile << "  \"stages\": {";
+    for(int k = neuron::STAGE_PATTERN; k < neuron::STAGE_COUNT; k++)
+    {
+        savedFile << (k > neuron::STAGE_PATTERN ? "," : "") << "\n    \"" << neuron::STAGE_NAMES[k] << "\": {"
+                  << "\"runs\": " << total.stageRuns[k] << ", \"wall_seconds\": " << total.stageWall[k]
+                  << ", \"cpu_seconds\": " << total.stageCPU[k] << "}";
+    }
+    savedFile << "\n  },\n  \"counters\": {";
+    for(int k = 0; k < PROFILE_INTERSECTIONS; k++)
+        savedFile << (k > 0 ? "," : "") << "\n    \"" << COUNTER_NAMES[k] << "\": " << total.counters[k];
+    savedFile << ",\n    \"range_candidates_per_query\": "
+              << (total.counters[PROFILE_RANGE_QUERIES] > 0 ?
+                  double(total.counters[PROFILE_RANGE_CANDIDATES])/total.counters[PROFILE_RANGE_QUERIES] : 0.);
+    savedFile << "\n  },\n  \"intersection_tests\": {";
+    for(int a = 0; a < PROFILE_DEFECT_TYPES; a++)
+    {
+        for(int b = 0; b < PROFILE_DEFECT_TYPES; b++)
+        {
+            savedFile << (a+b > 0 ? "," : "") << "\n    \"" << DEFECT_TYPE_NAMES[a] << "-" << DEFECT_TYPE_NAMES[b]
+                      << "\": " << total.counters[PROFILE_INTERSECTIONS+a*PROFILE_DEFECT_TYPES+b];
+        }
+    }
+    savedFile << "\n  }\n}\n";
+    savedFile.close();
+    return true;
+}
+
+ProfileScope::ProfileScope(int stg)
+{
+    stage = stg;
+    wall = Profiler::wallTime();
+    cpu = Profiler::cpuTime();
+}
+
+ProfileScope::~ProfileScope()
+{
+    Profiler::addStage(stage, Profiler::wallTime()-wall, Profiler::cpuTime()-cpu);
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "neuronnamespace.h"
+
+// Hot path counters and stage timers. They are only compiled in when
+// NEURONGEN_PROFILE is defined (see neurongen.pri), otherwise the macros
+// below expand to nothing. Every thread counts on its own block, the
+// blocks are only added up when the report is written.
+
+// Same order as defectType
+#define PROFILE_DEFECT_TYPES 5
+
+enum profileCounter
+{
+    PROFILE_PLACEMENT_RETRIES,
+    PROFILE_PLACEMENT_LIMIT,
+    PROFILE_AXON_RETRIES,
+    PROFILE_AXON_TRIALS,
+    PROFILE_AXON_LIMIT,
+    PROFILE_RANGE_QUERIES,
+    PROFILE_RANGE_CANDIDATES,
+    // Defect::intersect calls, one counter per (defect, tested defect) type pair
+    PROFILE_INTERSECTIONS,
+    PROFILE_COUNTERS = PROFILE_INTERSECTIONS+PROFILE_DEFECT_TYPES*PROFILE_DEFECT_TYPES
+};
+
+typedef struct profileBlock
+{
+    int64_t counters[PROFILE_COUNTERS];
+    int64_t stageRuns[neuron::STAGE_COUNT];
+    double stageWall[neuron::STAGE_COUNT], stageCPU[neuron::STAGE_COUNT];
+    // Keeps the blocks of different threads in different cache lines
+    char padding[64];
+} profileBlock;
+
+class Profiler
+{
+    public:
+        static inline void count(int counter, int64_t amount)
+            {localBlock()->counters[counter] += amount;}
+        static void addStage(int stage, double wall, double cpu);
+        static bool isEnabled();
+        static void reset();
+        static bool save(std::string fileName);
+        static double wallTime();
+        static double cpuTime();
+
+    private:
+        static inline profileBlock* localBlock()
+            {return local ? local : registerThread();}
+        static profileBlock* registerThread();
+        static __thread profileBlock* local;
+};
+
+// Adds the wall and CPU time of its lifetime to a stage. The CPU time is
+// the one of the whole process, so it includes every thread of the stage
+class ProfileScope
+{
+    public:
+        ProfileScope(int stg);
+        ~ProfileScope();
+
+    private:
+        int stage;
+        double wall, cpu;
+};
+
+#ifdef NEURONGEN_PROFILE
+#define PROFILE_COUNT(counter) Profiler::count(counter, 1)
+#define PROFILE_ADD(counter, amount) Profiler::count(counter, amount)
+#define PROFILE_STAGE(stage) ProfileScope profileScope(stage)
+#else
+#define PROFILE_COUNT(counter) ((void)0)
+#define PROFILE_ADD(counter, amount) ((void)0)
+#define PROFILE_STAGE(stage) ((void)0)
+#endif
+
+#endif
+    // _PROFILER_H_
+
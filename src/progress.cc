@@ -0,0 +1,272 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <errno.h>
+#include <sys/time.h>
+#include "profiler.h"
+#include "progress.h"
+
+// Shortest refresh interval, in seconds
+#define PROGRESS_MIN_INTERVAL 0.05
+
+static const char* STAGE_LABELS[neuron::STAGE_COUNT] = {"", "Loading Pattern...", "Loading Density Map...",
+                                                         "Placing Neuron...", "Growing Axon...",
+                                                         "Growing Dendrites...", "Creating Output Connection..."};
+
+// Lines of several chambers (ensembles) must not mix
+static pthread_mutex_t outputMutex = PTHREAD_MUTEX_INITIALIZER;
+// Open streams and the number of Progress objects writing to each one.
+// A stream is closed when its last user releases it, a later open of the
+// same file appends to it
+typedef struct progressStream
+{
+    std::ofstream* file;
+    int users;
+} progressStream;
+static std::map<std::string, progressStream> streams;
+static std::set<std::string> closedStreams;
+
+Progress::Progress()
+{
+    callback = NULL;
+    callbackData = NULL;
+    quiet = false;
+    interval = 1.0;
+    stream = NULL;
+    id = 0;
+    stage = neuron::STAGE_NONE;
+    total = 0;
+    done = 0;
+    retries = 0;
+    startTime = 0;
+    running = false;
+    stopping = false;
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&wake, NULL);
+}
+
+Progress::~Progress()
+{
+    if(running)
+    {
+        pthread_mutex_lock(&mutex);
+        stopping = true;
+        pthread_cond_signal(&wake);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(reporter, NULL);
+    }
+    releaseStream(stream);
+    pthread_cond_destroy(&wake);
+    pthread_mutex_destroy(&mutex);
+}
+
+// Takes over the reference to the stream returned by openStream, id tells
+// apart the lines of several networks (the seed)
+void Progress::setOutput(bool q, double inter, std::ostream* str, int identifier)
+{
+    quiet = q;
+    interval = std::max(inter, PROGRESS_MIN_INTERVAL);
+    releaseStream(stream);
+    stream = str;
+    id = identifier;
+}
+
+void Progress::copySettings(const Progress& other)
+{
+    setCallback(other.callback, other.callbackData);
+    retainStream(other.stream);
+    setOutput(other.quiet, other.interval, other.stream, other.id);
+}
+
+// Every network (sweep points, realizations, server requests) writing to
+// the same file shares one stream. An empty name means no stream. The
+// caller gets a reference, which setOutput takes over
+std::ostream* Progress::openStream(std::string fileName)
+{
+    std::ofstream* newStream;
+    std::ios_base::openmode mode = std::ios_base::out;
+
+    if(fileName.empty())
+        return NULL;
+    pthread_mutex_lock(&outputMutex);
+    std::map<std::string, progressStream>::iterator i = streams.find(fileName);
+    if(i != streams.end())
+    {
+        i->second.users++;
+        pthread_mutex_unlock(&outputMutex);
+        return i->second.file;
+    }
+    if(closedStreams.count(fileName))
+        mode |= std::ios_base::app;
+    newStream = new std::ofstream(fileName.c_str(), mode);
+    if(!newStream->is_open())
+    {
+        std::cout << "There was an error opening file " << fileName << "\n";
+        delete newStream;
+        pthread_mutex_unlock(&outputMutex);
+        return NULL;
+    }
+    streams[fileName].file = newStream;
+    streams[fileName].users = 1;
+    pthread_mutex_unlock(&outputMutex);
+    return newStream;
+}
+
+void Progress::retainStream(std::ostream* str)
+{
+    if(!str)
+        return;
+    pthread_mutex_lock(&outputMutex);
+    for(std::map<std::string, progressStream>::iterator i = streams.begin(); i != streams.end(); i++)
+    {
+        if(i->second.file == str)
+        {
+            i->second.users++;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&outputMutex);
+}
+
+// Flushes and closes the stream once nobody writes to it
+void Progress::releaseStream(std::ostream* str)
+{
+    if(!str)
+        return;
+    pthread_mutex_lock(&outputMutex);
+    for(std::map<std::string, progressStream>::iterator i = streams.begin(); i != streams.end(); i++)
+    {
+        if(i->second.file == str)
+        {
+            if(--i->second.users <= 0)
+            {
+                i->second.file->close();
+                delete i->second.file;
+                closedStreams.insert(i->first);
+                streams.erase(i);
+            }
+            break;
+        }
+    }
+    pthread_mutex_unlock(&outputMutex);
+}
+
+void Progress::start(int stg, int64_t tot)
+{
+    if(running)
+        finish();
+    stage = stg;
+    total = tot;
+    __atomic_store_n(&done, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&retries, 0, __ATOMIC_RELAXED);
+    startTime = Profiler::wallTime();
+    stopping = false;
+    // Nobody would see the intermediate reports
+    if(quiet && !stream && !callback)
+        return;
+    running = pthread_create(&reporter, NULL, reporterLoop, this) == 0;
+}
+
+void Progress::finish()
+{
+    if(running)
+    {
+        pthread_mutex_lock(&mutex);
+        stopping = true;
+        pthread_cond_signal(&wake);
+        pthread_mutex_unlock(&mutex);
+        pthread_join(reporter, NULL);
+        running = false;
+    }
+    __atomic_store_n(&done, total, __ATOMIC_RELAXED);
+    report(true);
+}
+
+void* Progress::reporterLoop(void* object)
+{
+    Progress* progress = static_cast<Progress*>(object);
+    struct timeval now;
+    struct timespec deadline;
+    double next;
+
+    pthread_mutex_lock(&progress->mutex);
+    while(!progress->stopping)
+    {
+        gettimeofday(&now, NULL);
+        next = now.tv_sec+now.tv_usec*1e-6+progress->interval;
+        deadline.tv_sec = time_t(next);
+        deadline.tv_nsec = long((next-floor(next))*1e9);
+        while(!progress->stopping)
+        {
+            if(pthread_cond_timedwait(&progress->wake, &progress->mutex, &deadline) == ETIMEDOUT)
+                break;
+        }
+        if(progress->stopping)
+            break;
+        pthread_mutex_unlock(&progress->mutex);
+        progress->report(false);
+        pthread_mutex_lock(&progress->mutex);
+    }
+    pthread_mutex_unlock(&progress->mutex);
+    return NULL;
+}
+
+void Progress::report(bool final)
+{
+    int64_t current = __atomic_load_n(&done, __ATOMIC_RELAXED);
+    int64_t retried = __atomic_load_n(&retries, __ATOMIC_RELAXED);
+    double elapsed = Profiler::wallTime()-startTime;
+    double rate = elapsed > 0 ? current/elapsed : 0;
+    double eta = rate > 0 ? (total-current)/rate : -1;
+    double retryRate = current > 0 ? double(retried)/current : 0;
+    std::stringstream line;
+
+    if(callback)
+        callback(stage, int(current), int(total), callbackData);
+    if(quiet && !stream)
+        return;
+
+    pthread_mutex_lock(&outputMutex);
+    if(!quiet)
+    {
+        line << STAGE_LABELS[stage] << " " << current << "/" << total;
+        if(final)
+            line << " done in " << elapsed << " s (" << rate << " per s";
+        else
+            line << " (" << rate << " per s, ETA " << (eta < 0 ? 0 : eta) << " s";
+        if(retried > 0)
+            line << ", " << retryRate << " retries per neuron";
+        line << ")\n";
+        std::cout << line.str();
+        std::cout.flush();
+    }
+    if(stream)
+    {
+        *stream << "{\"id\": " << id << ", \"stage\": \"" << neuron::STAGE_NAMES[stage] << "\", \"done\": "
+                << current << ", \"total\": " << total << ", \"elapsed\": " << elapsed << ", \"rate\": " << rate
+                << ", \"eta\": " << (final ? 0 : eta) << ", \"retries\": " << retried << ", \"retry_rate\": "
+                << retryRate << ", \"final\": " << (final ? "true" : "false") << "}\n";
+        stream->flush();
+    }
+    pthread_mutex_unlock(&outputMutex);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _PROGRESS_H_
+#define _PROGRESS_H_
+
+#include <ostream>
+#include <string>
+#include <pthread.h>
+#include <stdint.h>
+#include "neuronnamespace.h"
+
+// Progress of the stages of one chamber. The stage loops only bump
+// relaxed atomic counters (advance, retry), so they can run in parallel.
+// While a stage runs, a reporter thread prints the rate, the ETA and the
+// retries per item every interval seconds, writes them as JSON lines to
+// the machine readable stream (if any) and calls the progress callback.
+// The final report of a stage is made by finish, on the calling thread.
+// The streams returned by openStream are shared and closed once the last
+// Progress using them is destroyed.
+class Progress
+{
+    public:
+        Progress();
+        ~Progress();
+        inline void setCallback(neuron::progressCallback cb, void* data)
+            {callback = cb;
+             callbackData = data;}
+        void setOutput(bool q, double inter, std::ostream* str, int identifier);
+        void copySettings(const Progress& other);
+        void start(int stg, int64_t tot);
+        inline void advance(int64_t count = 1)
+            {__atomic_fetch_add(&done, count, __ATOMIC_RELAXED);}
+        inline void retry(int64_t count = 1)
+            {__atomic_fetch_add(&retries, count, __ATOMIC_RELAXED);}
+        void finish();
+        static std::ostream* openStream(std::string fileName);
+
+    private:
+        Progress(const Progress&);
+        Progress& operator=(const Progress&);
+        static void* reporterLoop(void* object);
+        static void retainStream(std::ostream* str);
+        static void releaseStream(std::ostream* str);
+        void report(bool final);
+
+        neuron::progressCallback callback;
+        void* callbackData;
+        bool quiet;
+        double interval;
+        std::ostream* stream;
+        int id;
+
+        int stage;
+        int64_t total, done, retries;
+        double startTime;
+        bool running, stopping;
+        pthread_t reporter;
+        pthread_mutex_t mutex;
+        pthread_cond_t wake;
+};
+
+#endif
+    // _PROGRESS_H_
+
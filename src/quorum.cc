@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "random.h"
+#include "quorum.h"
+
+Quorum::Quorum(const Adjacency& adjacency)
+{
+    output = adjacency;
+    sweepThreshold = 0;
+    sweepRuns = 0;
+}
+
+// Returns the final active fraction
+double Quorum::activate(double f, int threshold, gsl_rng* rng)
+{
+    std::vector<int> activeInputs;
+    std::vector<int32_t> queue;
+    return activate(f, threshold, rng, activeInputs, queue);
+}
+
+// Work buffers are passed in so repeated runs do not allocate. Neurons
+// are marked active by setting their count to -1
+double Quorum::activate(double f, int threshold, gsl_rng* rng, std::vector<int>& activeInputs,
+                        std::vector<int32_t>& queue)
+{
+    const std::vector<int64_t>& offsets = output.getOffsets();
+    const std::vector<int32_t>& targets = output.getTargets();
+    int nodes = output.getNodeCount();
+    size_t head = 0;
+
+    activeInputs.assign(nodes, 0);
+    queue.clear();
+    queue.reserve(nodes);
+    for(int i = 0; i < nodes; i++)
+    {
+        if(gsl_rng_uniform(rng) < f)
+        {
+            activeInputs[i] = -1;
+            queue.push_back(i);
+        }
+    }
+    while(head < queue.size())
+    {
+        int32_t i = queue[head++];
+        for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+        {
+            int32_t j = targets[e];
+            if(activeInputs[j] >= 0 && ++activeInputs[j] >= threshold)
+            {
+                activeInputs[j] = -1;
+                queue.push_back(j);
+            }
+        }
+    }
+    return nodes > 0 ? double(queue.size())/nodes : 0;
+}
+
+// runs independent initial conditions for every value of f, all in
+// parallel. Run r of point k draws from stream k*runs+r of seed
+void Quorum::sweep(const std::vector<double>& f, int threshold, int runs, int seed)
+{
+    int points = f.size();
+    std::vector<double> sum(points, 0), sumSquares(points, 0);
+
+    sweepThreshold = threshold;
+    sweepRuns = runs;
+    #pragma omp parallel
+    {
+        std::vector<int> activeInputs;
+        std::vector<int32_t> queue;
+        std::vector<double> localSum(points, 0), localSquares(points, 0);
+        gsl_rng* rng = gsl_rng_alloc(gsl_rng_taus2);
+
+        #pragma omp for schedule(dynamic)
+        for(int64_t job = 0; job < int64_t(points)*runs; job++)
+        {
+            int k = job/runs;
+            double active;
+            gsl_rng_set(rng, Random::streamSeed(seed, uint32_t(job), STREAM_QUORUM));
+            active = activate(f[k], threshold, rng, activeInputs, queue);
+            localSum[k] += active;
+            localSquares[k] += active*active;
+        }
+        gsl_rng_free(rng);
+
+        #pragma omp critical
+        for(int k = 0; k < points; k++)
+        {
+            sum[k] += localSum[k];
+            sumSquares[k] += localSquares[k];
+        }
+    }
+
+    fraction = f;
+    activeMean.resize(points);
+    activeStd.resize(points);
+    for(int k = 0; k < points; k++)
+    {
+        activeMean[k] = runs > 0 ? sum[k]/runs : 0;
+        activeStd[k] = runs > 0 ? sqrt(std::max(0.0, sumSquares[k]/runs-activeMean[k]*activeMean[k])) : 0;
+    }
+}
+
+bool Quorum::save(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    savedFile.precision(10);
+    savedFile << "% Quorum percolation, threshold " << sweepThreshold << ", " << sweepRuns << " runs per point\n";
+    savedFile << "% initial_fraction final_fraction_mean final_fraction_std\n";
+    for(size_t k = 0; k < fraction.size(); k++)
+        savedFile << fraction[k] << " " << activeMean[k] << " " << activeStd[k] << "\n";
+    savedFile.close();
+    return true;
+}
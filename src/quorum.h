@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _QUORUM_H_
+#define _QUORUM_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "gsl/gsl_rng.h"
+#include "adjacency.h"
+#include "neuronnamespace.h"
+
+// Quorum (bootstrap) percolation: a neuron becomes active once threshold
+// of its inputs are active. Starting from a random fraction f of active
+// neurons the activation spreads through a queue, so every neuron and
+// connection is processed at most once per run.
+class Quorum
+{
+    public:
+        Quorum(const Adjacency& adjacency);
+        double activate(double f, int threshold, gsl_rng* rng);
+        void sweep(const std::vector<double>& f, int threshold, int runs, int seed);
+        bool save(std::string fileName);
+
+    private:
+        double activate(double f, int threshold, gsl_rng* rng, std::vector<int>& activeInputs,
+                        std::vector<int32_t>& queue);
+
+        Adjacency output;
+        int sweepThreshold, sweepRuns;
+        std::vector<double> fraction, activeMean, activeStd;
+};
+
+#endif
+    // _QUORUM_H_
+
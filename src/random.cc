@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "random.h"
+
+static inline uint64_t rotateLeft(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64-k));
+}
+
+static inline uint64_t splitMix(uint64_t& x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Blocks are generated on the first draw after seeding
+static void startState(randomState* state, int engine)
+{
+    state->engine = engine;
+    state->counter = 0;
+    state->rawNext = RANDOM_BLOCK;
+    state->normalNext = RANDOM_BLOCK;
+}
+
+static void xoshiroSet(void* vstate, unsigned long seed)
+{
+    randomState* state = static_cast<randomState*>(vstate);
+    uint64_t x = seed;
+
+    for(int k = 0; k < 16; k++)
+        state->key[k] = splitMix(x);
+    startState(state, RANDOM_XOSHIRO);
+}
+
+// Key from the seed, the counter is the position in the stream
+static void philoxSet(void* vstate, unsigned long seed)
+{
+    randomState* state = static_cast<randomState*>(vstate);
+    uint64_t x = seed;
+
+    state->key[0] = splitMix(x);
+    startState(state, RANDOM_PHILOX);
+}
+
+// What gsl_rng_get and gsl_rng_uniform draw, from the same blocks. The
+// integers are the upper 32 bits of the raw outputs
+static unsigned long blockGet(void* vstate)
+{
+    return (unsigned long)(Random::next(static_cast<randomState*>(vstate)) >> 32);
+}
+
+static double blockGetDouble(void* vstate)
+{
+    return Random::nextUniform(static_cast<randomState*>(vstate));
+}
+
+static const gsl_rng_type XOSHIRO_TYPE = {"xoshiro256++", 0xFFFFFFFFUL, 0, sizeof(randomState),
+                                          &xoshiroSet, &blockGet, &blockGetDouble};
+static const gsl_rng_type PHILOX_TYPE = {"philox4x32-10", 0xFFFFFFFFUL, 0, sizeof(randomState),
+                                         &philoxSet, &blockGet, &blockGetDouble};
+const gsl_rng_type* const Random::xoshiroType = &XOSHIRO_TYPE;
+const gsl_rng_type* const Random::philoxType = &PHILOX_TYPE;
+
+uint64_t Random::streamSeed(uint32_t seed, uint32_t index, int salt)
+{
+    uint64_t x = (uint64_t(seed) << 32 | index)+0x9E3779B97F4A7C15ull*uint64_t(salt);
+    return splitMix(x);
+}
+
+const gsl_rng_type* Random::engineType(int engine)
+{
+    switch(engine)
+    {
+        case RANDOM_XOSHIRO:
+            return xoshiroType;
+        case RANDOM_PHILOX:
+            return philoxType;
+        case RANDOM_GSL:
+        default:
+            return gsl_rng_taus2;
+    }
+}
+
+bool Random::parseEngine(std::string name, int& engine)
+{
+    if(name == "gsl")
+        engine = RANDOM_GSL;
+    else if(name == "xoshiro")
+        engine = RANDOM_XOSHIRO;
+    else if(name == "philox")
+        engine = RANDOM_PHILOX;
+    else
+        return false;
+    return true;
+}
+
+// xoshiro256++ (Blackman and Vigna) on four generators at once, output
+// k of the block comes from generator k%4
+static void xoshiroBlock(randomState* state)
+{
+    uint64_t* s0 = state->key;
+    uint64_t* s1 = state->key+4;
+    uint64_t* s2 = state->key+8;
+    uint64_t* s3 = state->key+12;
+
+    for(int i = 0; i < RANDOM_BLOCK; i += 4)
+    {
+        #pragma omp simd
+        for(int k = 0; k < 4; k++)
+        {
+            uint64_t t = s1[k] << 17;
+            state->raw[i+k] = rotateLeft(s0[k]+s3[k], 23)+s0[k];
+            s2[k] ^= s0[k];
+            s3[k] ^= s1[k];
+            s1[k] ^= s2[k];
+            s0[k] ^= s3[k];
+            s2[k] ^= t;
+            s3[k] = rotateLeft(s3[k], 45);
+        }
+    }
+}
+
+// Philox4x32-10 (Salmon et al. 2011), counters counter, counter+1... in
+// the two low words. Every counter gives two outputs
+static void philoxBlock(randomState* state)
+{
+    uint32_t key0 = uint32_t(state->key[0]), key1 = uint32_t(state->key[0] >> 32);
+    uint64_t base = state->counter;
+
+    #pragma omp simd
+    for(int i = 0; i < RANDOM_BLOCK/2; i++)
+    {
+        uint64_t counter = base+i;
+        uint32_t c0 = uint32_t(counter), c1 = uint32_t(counter >> 32), c2 = 0, c3 = 0;
+        uint32_t k0 = key0, k1 = key1;
+        for(int round = 0; round < 10; round++)
+        {
+            uint64_t p0 = uint64_t(0xD2511F53u)*c0, p1 = uint64_t(0xCD9E8D57u)*c2;
+            c0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+            c2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+            c1 = uint32_t(p1);
+            c3 = uint32_t(p0);
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        state->raw[2*i] = uint64_t(c1) << 32 | c0;
+        state->raw[2*i+1] = uint64_t(c3) << 32 | c2;
+    }
+    state->counter += RANDOM_BLOCK/2;
+}
+
+void Random::refill(randomState* state)
+{
+    if(state->engine == RANDOM_PHILOX)
+        philoxBlock(state);
+    else
+        xoshiroBlock(state);
+    state->rawNext = 0;
+}
+
+// Box-Muller on a block of uniforms, no rejection so the loop vectorizes
+void Random::refillNormals(randomState* state)
+{
+    double u[RANDOM_BLOCK];
+
+    for(int i = 0; i < RANDOM_BLOCK; i++)
+        u[i] = nextUniform(state);
+    #pragma omp simd
+    for(int i = 0; i < RANDOM_BLOCK/2; i++)
+    {
+        double radius = sqrt(-2*log(1-u[2*i])), angle = 2*M_PI*u[2*i+1];
+        state->normal[2*i] = radius*cos(angle);
+        state->normal[2*i+1] = radius*sin(angle);
+    }
+    state->normalNext = 0;
+}
+
+// The fills give the same numbers as count single draws
+void Random::fillUniform(const gsl_rng* rng, double* out, int count)
+{
+    for(int i = 0; i < count; i++)
+        out[i] = uniform(rng);
+}
+
+void Random::fillGaussian(const gsl_rng* rng, double* out, int count, double sigma)
+{
+    if(!isBlock(rng))
+    {
+        for(int i = 0; i < count; i++)
+            out[i] = gsl_ran_gaussian_ziggurat(rng, sigma);
+        return;
+    }
+    randomState* state = static_cast<randomState*>(rng->state);
+    for(int i = 0; i < count; i++)
+        out[i] = nextNormal(state);
+    #pragma omp simd
+    for(int i = 0; i < count; i++)
+        out[i] *= sigma;
+}
+
+void Random::fillRayleigh(const gsl_rng* rng, double* out, int count, double sigma)
+{
+    if(!isBlock(rng))
+    {
+        for(int i = 0; i < count; i++)
+            out[i] = gsl_ran_rayleigh(rng, sigma);
+        return;
+    }
+    randomState* state = static_cast<randomState*>(rng->state);
+    for(int i = 0; i < count; i++)
+        out[i] = nextUniform(state);
+    #pragma omp simd
+    for(int i = 0; i < count; i++)
+        out[i] = sigma*sqrt(-2*log(1-out[i]));
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _RANDOM_H_
+#define _RANDOM_H_
+
+#include <cmath>
+#include <string>
+#include <stdint.h>
+#include "gsl/gsl_rng.h"
+#include "gsl/gsl_randist.h"
+
+// Raw outputs (and normals) generated at a time by the block engines
+#define RANDOM_BLOCK 256
+
+enum randomEngine { RANDOM_GSL, RANDOM_XOSHIRO, RANDOM_PHILOX };
+// Users of Random::streamSeed, each one derives its streams with its own
+// salt
+enum randomStream { STREAM_GENERATION, STREAM_PERCOLATION, STREAM_QUORUM, STREAM_NULL_MODEL, STREAM_DYNAMICS, STREAM_ENSEMBLE,
+                   STREAM_STATISTICS };
+
+// State of the block engines. It is a plain gsl_rng state, so the
+// checkpoints save it (buffers included) like the one of any GSL
+// generator
+typedef struct randomState
+{
+    // xoshiro256++: four interleaved generators, word w of generator k in
+    // key[4*w+k]. Philox4x32-10: key in key[0] and the block counter
+    uint64_t key[16];
+    uint64_t counter;
+    uint64_t raw[RANDOM_BLOCK];
+    double normal[RANDOM_BLOCK];
+    int32_t engine, rawNext, normalNext;
+} randomState;
+
+// Engines and draws of the generation stages. xoshiro256++ and
+// Philox4x32-10 are registered as GSL generator types, so everything that
+// takes a gsl_rng (gsl_ran_discrete, the checkpoints...) works with them.
+// They produce their output in blocks, and the draws below take uniforms
+// and normals from those blocks instead of calling through the generator
+// type for every number. Any other generator (taus2 by default) goes to
+// the GSL functions the stages always used, so old results are reproduced
+// exactly
+class Random
+{
+    public:
+        static const gsl_rng_type* engineType(int engine);
+        static bool parseEngine(std::string name, int& engine);
+        // Seed of stream index of a parallel loop (splitmix64 of the seed,
+        // the index and the salt). Every stream only depends on these, so
+        // the results do not depend on the number of threads, and the
+        // streams neither overlap nor replay a generator seeded with seed
+        static uint64_t streamSeed(uint32_t seed, uint32_t index, int salt = STREAM_GENERATION);
+
+        static inline bool isBlock(const gsl_rng* rng)
+            {return rng->type == xoshiroType || rng->type == philoxType;}
+        static inline double uniform(const gsl_rng* rng)
+            {return isBlock(rng) ? nextUniform(static_cast<randomState*>(rng->state)) : gsl_rng_uniform(rng);}
+        static inline double flat(const gsl_rng* rng, double a, double b)
+            {double u = uniform(rng);
+             return a*(1-u)+b*u;}
+        static inline double gaussian(const gsl_rng* rng, double sigma)
+            {return isBlock(rng) ? sigma*nextNormal(static_cast<randomState*>(rng->state))
+                                 : gsl_ran_gaussian_ziggurat(rng, sigma);}
+        static inline double rayleigh(const gsl_rng* rng, double sigma)
+            {return isBlock(rng) ? sigma*sqrt(-2*log(1-nextUniform(static_cast<randomState*>(rng->state))))
+                                 : gsl_ran_rayleigh(rng, sigma);}
+        static void fillUniform(const gsl_rng* rng, double* out, int count);
+        static void fillGaussian(const gsl_rng* rng, double* out, int count, double sigma);
+        static void fillRayleigh(const gsl_rng* rng, double* out, int count, double sigma);
+
+        // Raw access to a block engine state
+        static inline uint64_t next(randomState* state)
+            {if(state->rawNext == RANDOM_BLOCK)
+                 refill(state);
+             return state->raw[state->rawNext++];}
+        static inline double nextUniform(randomState* state)
+            {return (next(state) >> 11)*(1./9007199254740992.);}
+        static inline double nextNormal(randomState* state)
+            {if(state->normalNext == RANDOM_BLOCK)
+                 refillNormals(state);
+             return state->normal[state->normalNext++];}
+
+    private:
+        static void refill(randomState* state);
+        static void refillNormals(randomState* state);
+
+        static const gsl_rng_type* const xoshiroType;
+        static const gsl_rng_type* const philoxType;
+};
+
+#endif
+    // _RANDOM_H_
@@ -0,0 +1,456 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "server.h"
+#include "network.h"
+#include "numpyio.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Largest request frame accepted (configs are small text files)
+#define SERVER_MAX_FRAME (64*1024*1024)
+
+Server::Server()
+{
+    socketFile = "/tmp/neurongen.sock";
+    workers = 0;
+    cacheSize = 8;
+    listener = -1;
+    pthread_mutex_init(&queueMutex, NULL);
+    pthread_mutex_init(&cacheMutex, NULL);
+    pthread_cond_init(&queueReady, NULL);
+}
+
+Server::~Server()
+{
+    for(std::map<uint64_t, cacheEntry>::iterator i = cache.begin(); i != cache.end(); i++)
+        delete i->second.base;
+    if(listener >= 0)
+    {
+        close(listener);
+        unlink(socketFile.c_str());
+    }
+    pthread_mutex_destroy(&queueMutex);
+    pthread_mutex_destroy(&cacheMutex);
+    pthread_cond_destroy(&queueReady);
+}
+
+// Server settings come from the network.serve group, all optional
+bool Server::load(std::string fileName)
+{
+    libconfig::Config config;
+
+    try
+    {
+        config.readFile(fileName.c_str());
+    }
+    catch(libconfig::ParseException e)
+    {
+        std::cout << e.getLine() << " " << e.getError() << "\n";
+        return false;
+    }
+    catch(libconfig::FileIOException e)
+    {
+        std::cout << "No config file found, using the default server settings\n";
+        return true;
+    }
+    config.setAutoConvert(true);
+    config.lookupValue("network.serve.socket", socketFile);
+    config.lookupValue("network.serve.workers", workers);
+    config.lookupValue("network.serve.cache_size", cacheSize);
+    return true;
+}
+
+void Server::run()
+{
+    struct sockaddr_un address;
+    std::vector<pthread_t> threads;
+    int client;
+
+    if(workers <= 0)
+        workers = std::max(1, int(sysconf(_SC_NPROCESSORS_ONLN)));
+    if(socketFile.size() >= sizeof(address.sun_path))
+    {
+        std::cout << "Error. Socket path too long: " << socketFile << "\n";
+        exit(1);
+    }
+    // Clients closing early should not kill the server
+    signal(SIGPIPE, SIG_IGN);
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketFile.c_str(), sizeof(address.sun_path)-1);
+    unlink(socketFile.c_str());
+    if(listener < 0 || bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0
+       || listen(listener, SOMAXCONN) < 0)
+    {
+        std::cout << "Error. Could not listen on " << socketFile << ": " << strerror(errno) << "\n";
+        exit(1);
+    }
+
+    threads.resize(workers);
+    for(int i = 0; i < workers; i++)
+        pthread_create(&threads[i], NULL, worker, this);
+    std::cout << "Serving on " << socketFile << " with " << workers << " workers\n";
+
+    while(true)
+    {
+        client = accept(listener, NULL, NULL);
+        if(client < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            std::cout << "Error. accept failed: " << strerror(errno) << "\n";
+            break;
+        }
+        pthread_mutex_lock(&queueMutex);
+        clients.push_back(client);
+        pthread_cond_signal(&queueReady);
+        pthread_mutex_unlock(&queueMutex);
+    }
+}
+
+void* Server::worker(void* server)
+{
+    Server* self = static_cast<Server*>(server);
+    int client;
+
+    while(true)
+    {
+        pthread_mutex_lock(&self->queueMutex);
+        while(self->clients.empty())
+            pthread_cond_wait(&self->queueReady, &self->queueMutex);
+        client = self->clients.front();
+        self->clients.pop_front();
+        pthread_mutex_unlock(&self->queueMutex);
+
+        self->handleClient(client);
+        close(client);
+    }
+    return NULL;
+}
+
+void Server::handleClient(int client)
+{
+    std::string configText, overrides, mode, status, payload;
+
+    while(readFrame(client, configText) && readFrame(client, overrides) && readFrame(client, mode))
+    {
+        payload.clear();
+        if(!handleRequest(configText, overrides, mode, status, payload))
+            status = "ERROR "+status;
+        if(!writeFrame(client, status))
+            return;
+        if(mode == "npz" && status.compare(0, 2, "OK") == 0 && !writeFrame(client, payload))
+            return;
+    }
+}
+
+// Returns false with the reason in status if the request is not valid
+bool Server::handleRequest(std::string& configText, std::string& overrides, std::string& mode,
+                           std::string& status, std::string& payload)
+{
+    libconfig::Config config;
+    std::stringstream tmpStr;
+    std::string fileName;
+    bool tmpBool = false;
+    uint64_t keys[neuron::STAGE_COUNT];
+    Network* network;
+    Network* base;
+
+    if(mode.empty())
+        mode = "files";
+    if(mode != "files" && mode != "npz")
+    {
+        status = "Invalid reply mode: "+mode;
+        return false;
+    }
+    try
+    {
+        config.readString(configText);
+    }
+    catch(libconfig::ParseException e)
+    {
+        tmpStr << "Config line " << e.getLine() << ": " << e.getError();
+        status = tmpStr.str();
+        return false;
+    }
+    config.setAutoConvert(true);
+    if(!applyOverrides(config, overrides, status))
+        return false;
+
+    // parseConfig only prints these, check them first for the status
+    if(!config.lookupValue("network.generation", tmpBool) || !tmpBool)
+    {
+        status = "network.generation is not set";
+        return false;
+    }
+    if(!config.lookupValue("network.pattern.file", fileName) || !std::ifstream(fileName.c_str()).good())
+    {
+        status = "The pattern file is missing or can not be read";
+        return false;
+    }
+    if(config.lookupValue("network.densityMap.active", tmpBool) && tmpBool
+       && (!config.lookupValue("network.densityMap.file", fileName) || !std::ifstream(fileName.c_str()).good()
+           || !config.exists("network.densityMap.binWidth") || !config.exists("network.densityMap.binHeight")))
+    {
+        status = "The density map settings are incomplete or its file can not be read";
+        return false;
+    }
+
+    network = new Network();
+    if(!network->parseConfig(config))
+    {
+        delete network;
+        status = "The config does not generate a network";
+        return false;
+    }
+    // Files shared between requests are not written
+    network->resume = false;
+    network->checkpointActive = false;
+    network->cache = StageCache();
+
+    // Pattern and density map do not use the RNG, key them without the seed
+    network->seed = 0;
+    network->computeStageKeys(keys);
+    base = acquireBase(network, keys[neuron::STAGE_DENSITY_MAP]);
+    if(!base)
+    {
+        delete network;
+        status = "The pattern file can not be loaded";
+        return false;
+    }
+
+    network->chamber = base->chamber->createRealization();
+    network->chamber->setCultureParameters(network->cultureParams);
+    network->chamber->setNeuronParameters(network->somaParams, network->dtreeParams, network->axonParams);
+    network->seedRNG(network->fixedSeed);
+    for(int stage = neuron::STAGE_PLACEMENT; stage < neuron::STAGE_COUNT; stage++)
+        network->runStage(stage);
+
+    if(mode == "npz")
+    {
+        std::stringstream buffer(std::ios::out | std::ios::binary);
+        NumpyArchive archive(buffer);
+        network->writeNumpyArchive(archive);
+        payload = buffer.str();
+    }
+    else
+        network->saveOutputs();
+    tmpStr << "OK " << network->seed;
+    status = tmpStr.str();
+    delete network;
+    releaseBase(keys[neuron::STAGE_DENSITY_MAP]);
+    return true;
+}
+
+// Returns the preprocessed chamber for key, building it if needed, or NULL
+// if it can not be built. It can not be evicted until releaseBase is called
+Network* Server::acquireBase(Network* request, uint64_t key)
+{
+    std::map<uint64_t, cacheEntry>::iterator entry;
+    Network* base;
+
+    pthread_mutex_lock(&cacheMutex);
+    entry = cache.find(key);
+    if(entry != cache.end())
+    {
+        entry->second.users++;
+        recent.remove(key);
+        recent.push_front(key);
+        base = entry->second.base;
+        pthread_mutex_unlock(&cacheMutex);
+        return base;
+    }
+    pthread_mutex_unlock(&cacheMutex);
+
+    // Built without the lock, if another worker got there first ours is dropped
+    base = new Network(*request);
+    if(!base->buildChamber())
+    {
+        delete base;
+        return NULL;
+    }
+    base->chamber->assignLattice();
+    base->runStage(neuron::STAGE_PATTERN);
+    base->runStage(neuron::STAGE_DENSITY_MAP);
+
+    pthread_mutex_lock(&cacheMutex);
+    entry = cache.find(key);
+    if(entry != cache.end())
+    {
+        delete base;
+        base = entry->second.base;
+        entry->second.users++;
+        recent.remove(key);
+    }
+    else
+    {
+        cacheEntry newEntry = {base, 1};
+        cache[key] = newEntry;
+    }
+    recent.push_front(key);
+
+    // Evict the least recently used chambers nobody is using
+    for(std::list<uint64_t>::iterator i = recent.end(); int(cache.size()) > cacheSize && i != recent.begin();)
+    {
+        i--;
+        if(cache[*i].users == 0)
+        {
+            delete cache[*i].base;
+            cache.erase(*i);
+            i = recent.erase(i);
+        }
+    }
+    pthread_mutex_unlock(&cacheMutex);
+    return base;
+}
+
+void Server::releaseBase(uint64_t key)
+{
+    pthread_mutex_lock(&cacheMutex);
+    cache[key].users--;
+    pthread_mutex_unlock(&cacheMutex);
+}
+
+// Each line is key = value. Values keep the type of the setting they replace
+bool Server::applyOverrides(libconfig::Config& config, std::string& overrides, std::string& error)
+{
+    std::stringstream lines(overrides);
+    std::string line, key, value;
+    size_t separator;
+
+    while(std::getline(lines, line))
+    {
+        if(line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+        separator = line.find('=');
+        if(separator == std::string::npos)
+        {
+            error = "Invalid override: "+line;
+            return false;
+        }
+        key = line.substr(0, separator);
+        value = line.substr(separator+1);
+        key.erase(0, key.find_first_not_of(" \t"));
+        key.erase(key.find_last_not_of(" \t")+1);
+        value.erase(0, value.find_first_not_of(" \t"));
+        value.erase(value.find_last_not_of(" \t\r;")+1);
+        // Missing settings are added to their group with the type of the value
+        if(!config.exists(key.c_str()))
+        {
+            size_t dot = key.rfind('.');
+            libconfig::Setting::Type type = libconfig::Setting::TypeInt;
+            if(dot == std::string::npos || !config.exists(key.substr(0, dot).c_str())
+               || !config.lookup(key.substr(0, dot).c_str()).isGroup())
+            {
+                error = "Unknown setting: "+key;
+                return false;
+            }
+            if(!value.empty() && value[0] == '"')
+                type = libconfig::Setting::TypeString;
+            else if(value == "true" || value == "false")
+                type = libconfig::Setting::TypeBoolean;
+            else if(value.find_first_of(".eE") != std::string::npos)
+                type = libconfig::Setting::TypeFloat;
+            config.lookup(key.substr(0, dot).c_str()).add(key.substr(dot+1).c_str(), type);
+        }
+
+        libconfig::Setting& setting = config.lookup(key.c_str());
+        switch(setting.getType())
+        {
+            case libconfig::Setting::TypeInt:
+            case libconfig::Setting::TypeInt64:
+                setting = atoi(value.c_str());
+                break;
+            case libconfig::Setting::TypeFloat:
+                setting = atof(value.c_str());
+                break;
+            case libconfig::Setting::TypeBoolean:
+                setting = (value == "true");
+                break;
+            case libconfig::Setting::TypeString:
+                if(value.size() >= 2 && value[0] == '"' && value[value.size()-1] == '"')
+                    value = value.substr(1, value.size()-2);
+                setting = value;
+                break;
+            default:
+                error = "Only scalar settings can be overridden: "+key;
+                return false;
+        }
+    }
+    return true;
+}
+
+bool Server::readFrame(int fd, std::string& frame)
+{
+    unsigned char header[4];
+    uint32_t length;
+    size_t done = 0;
+    ssize_t count;
+
+    while(done < 4)
+    {
+        count = read(fd, header+done, 4-done);
+        if(count <= 0)
+            return false;
+        done += count;
+    }
+    length = uint32_t(header[0]) | (uint32_t(header[1]) << 8) | (uint32_t(header[2]) << 16) | (uint32_t(header[3]) << 24);
+    if(length > SERVER_MAX_FRAME)
+        return false;
+    frame.resize(length);
+    for(done = 0; done < length; done += count)
+    {
+        count = read(fd, &frame[done], length-done);
+        if(count <= 0)
+            return false;
+    }
+    return true;
+}
+
+bool Server::writeFrame(int fd, const std::string& frame)
+{
+    unsigned char header[4];
+    uint32_t length = frame.size();
+    size_t done;
+    ssize_t count;
+
+    header[0] = length & 0xFF;
+    header[1] = (length >> 8) & 0xFF;
+    header[2] = (length >> 16) & 0xFF;
+    header[3] = (length >> 24) & 0xFF;
+    if(write(fd, header, 4) != 4)
+        return false;
+    for(done = 0; done < frame.size(); done += count)
+    {
+        count = write(fd, frame.data()+done, frame.size()-done);
+        if(count <= 0)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _SERVER_H_
+#define _SERVER_H_
+
+#include <deque>
+#include <list>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <pthread.h>
+#include <libconfig.h++>
+#include "neuronnamespace.h"
+
+class Network;
+
+// Generation daemon (neurongen --serve). Listens on a Unix domain socket
+// and generates one network per request on a pool of worker threads. The
+// pattern lattice and density map of the most recently used chambers are
+// kept in memory, so requests for a known pattern only pay placement,
+// growth and connections.
+//
+// Every message is a frame: a 4 byte little-endian length and the data.
+// A request is three frames:
+//   1. The full config file (libconfig text)
+//   2. Overrides, one "key = value" per line (can be empty)
+//   3. The reply mode: "files" saves the outputs named in the config,
+//      "npz" sends the network back as an .npz archive
+// The reply is a status frame, "OK <seed>" or "ERROR <message>", followed
+// by the archive frame in npz mode. A connection can send any number of
+// requests. A request that can not be generated (bad settings, a pattern
+// that can not be loaded...) only gets its ERROR frame.
+class Server
+{
+    public:
+        Server();
+        ~Server();
+        bool load(std::string fileName);
+        void run();
+
+    private:
+        typedef struct cacheEntry
+        {
+            Network* base;
+            int users;
+        } cacheEntry;
+
+        static void* worker(void* server);
+        void handleClient(int client);
+        bool handleRequest(std::string& configText, std::string& overrides, std::string& mode,
+                           std::string& status, std::string& payload);
+        Network* acquireBase(Network* request, uint64_t key);
+        void releaseBase(uint64_t key);
+        static bool applyOverrides(libconfig::Config& config, std::string& overrides, std::string& error);
+        static bool readFrame(int fd, std::string& frame);
+        static bool writeFrame(int fd, const std::string& frame);
+
+        std::string socketFile;
+        int workers, cacheSize, listener;
+        std::deque<int> clients;
+        pthread_mutex_t queueMutex, cacheMutex;
+        pthread_cond_t queueReady;
+        std::map<uint64_t, cacheEntry> cache;
+        // Cache keys, most recently used first
+        std::list<uint64_t> recent;
+};
+
+#endif
+    // _SERVER_H_
+
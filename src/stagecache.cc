@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <errno.h>
+#include <fstream>
+#include <iomanip>
+#include "checkpoint.h"
+#include "stagecache.h"
+
+#define HASH_PRIME 1099511628211ull
+
+StageCache::StageCache()
+{
+    active = false;
+}
+
+StageCache::StageCache(std::string dir)
+{
+    active = true;
+    directory = dir;
+    if(mkdir(directory.c_str(), 0777) == -1 && errno != EEXIST)
+    {
+        std::cout << "Warning! Could not create the cache directory " << directory << ". Cache disabled\n";
+        active = false;
+    }
+}
+
+std::string StageCache::getFileName(uint64_t key)
+{
+    std::stringstream tmpStr;
+    tmpStr << directory << "/" << std::hex << std::setw(16) << std::setfill('0') << key << ".ngck";
+    return tmpStr.str();
+}
+
+bool StageCache::load(uint64_t key, Checkpoint& snapshot)
+{
+    if(!active)
+        return false;
+    return snapshot.load(getFileName(key));
+}
+
+bool StageCache::store(uint64_t key, Checkpoint& snapshot)
+{
+    if(!active)
+        return false;
+    return snapshot.save(getFileName(key));
+}
+
+// 64 bit FNV-1a
+uint64_t StageCache::hash(std::string data, uint64_t h)
+{
+    for(std::string::iterator i = data.begin(); i != data.end(); i++)
+    {
+        h ^= static_cast<unsigned char>(*i);
+        h *= HASH_PRIME;
+    }
+    return h;
+}
+
+// Files that cannot be read only contribute their name
+uint64_t StageCache::hashFile(std::string fileName, uint64_t h)
+{
+    std::ifstream inputFile(fileName.c_str(), std::ios::in | std::ios::binary);
+    char buffer[65536];
+
+    h = hash(fileName, h);
+    if(!inputFile.is_open())
+        return h;
+    while(inputFile)
+    {
+        inputFile.read(buffer, sizeof(buffer));
+        for(std::streamsize i = 0; i < inputFile.gcount(); i++)
+        {
+            h ^= static_cast<unsigned char>(buffer[i]);
+            h *= HASH_PRIME;
+        }
+    }
+    return h;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _STAGECACHE_H_
+#define _STAGECACHE_H_
+
+#include <string>
+#include <stdint.h>
+#include "neuronnamespace.h"
+
+class Checkpoint;
+
+// Directory of stage snapshots named after the hash of everything the
+// stage depends on (the config fields it reads, the contents of its input
+// files and the key of the previous stage, which starts from the seed)
+class StageCache
+{
+    public:
+        StageCache();
+        StageCache(std::string dir);
+        bool load(uint64_t key, Checkpoint& snapshot);
+        bool store(uint64_t key, Checkpoint& snapshot);
+        std::string getFileName(uint64_t key);
+        inline bool isActive()
+            {return active;}
+
+        static uint64_t hash(std::string data, uint64_t h = HASH_OFFSET);
+        static uint64_t hashFile(std::string fileName, uint64_t h = HASH_OFFSET);
+        static const uint64_t HASH_OFFSET = 14695981039346656037ull;
+
+    private:
+        bool active;
+        std::string directory;
+};
+
+#endif
+    // _STAGECACHE_H_
+
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include "gsl/gsl_randist.h"
+#include "statistics.h"
+
+// Pearson correlation from accumulated sums, 0 when a variable is constant
+static double pearson(double n, double sx, double sy, double sxx, double syy, double sxy)
+{
+    double den = (n*sxx-sx*sx)*(n*syy-sy*sy);
+    if(den <= 0)
+        return 0;
+    return (n*sxy-sx*sy)/sqrt(den);
+}
+
+Statistics::Statistics(const Adjacency& adjacency)
+{
+    output = adjacency;
+    computed = 0;
+    reciprocity = 0;
+    averageClustering = 0;
+    globalClustering = 0;
+    outInAssortativity = 0;
+    undirectedAssortativity = 0;
+    pathSources = 0;
+    meanPathLength = 0;
+    reachableFraction = 0;
+}
+
+// metrics is an OR of neuron::statisticsMetric flags
+void Statistics::compute(int metrics, int pathSamples, gsl_rng* rng)
+{
+    // Degrees are needed by everything else
+    computeDegrees();
+    if(metrics & neuron::STATS_RECIPROCITY)
+        computeReciprocity();
+    if(metrics & neuron::STATS_CLUSTERING)
+        computeClustering();
+    if(metrics & neuron::STATS_ASSORTATIVITY)
+        computeAssortativity();
+    if(metrics & neuron::STATS_PATHS)
+        computePaths(pathSamples, rng);
+    computed = metrics | neuron::STATS_DEGREES;
+}
+
+void Statistics::computeDegrees()
+{
+    int nodes = output.getNodeCount();
+
+    input = output.transpose();
+    undirected = output.symmetrize();
+    outDegree.resize(nodes);
+    inDegree.resize(nodes);
+    undirectedDegree.resize(nodes);
+    #pragma omp parallel for
+    for(int i = 0; i < nodes; i++)
+    {
+        outDegree[i] = output.getDegree(i);
+        inDegree[i] = input.getDegree(i);
+        undirectedDegree[i] = undirected.getDegree(i);
+    }
+}
+
+// Fraction of connections i->j for which j->i also exists
+void Statistics::computeReciprocity()
+{
+    Adjacency simple = output.simplify();
+    const std::vector<int64_t>& offsets = simple.getOffsets();
+    const std::vector<int32_t>& targets = simple.getTargets();
+    int nodes = simple.getNodeCount();
+    int64_t mutual = 0;
+
+    #pragma omp parallel for schedule(dynamic, 256) reduction(+:mutual)
+    for(int i = 0; i < nodes; i++)
+    {
+        for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+        {
+            int32_t j = targets[e];
+            if(std::binary_search(targets.begin()+offsets[j], targets.begin()+offsets[j+1], int32_t(i)))
+                mutual++;
+        }
+    }
+    reciprocity = simple.getEdgeCount() > 0 ? double(mutual)/simple.getEdgeCount() : 0;
+}
+
+// Triangles through every node from sorted neighbor list intersections
+void Statistics::computeClustering()
+{
+    const std::vector<int64_t>& offsets = undirected.getOffsets();
+    const std::vector<int32_t>& targets = undirected.getTargets();
+    int nodes = undirected.getNodeCount();
+    double triangles = 0, triples = 0, sum = 0;
+
+    localClustering.assign(nodes, 0);
+    #pragma omp parallel for schedule(dynamic, 64) reduction(+:triangles,triples,sum)
+    for(int i = 0; i < nodes; i++)
+    {
+        int64_t links = 0;
+        double k = undirectedDegree[i];
+        for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+        {
+            int32_t j = targets[e];
+            int64_t a = offsets[i], b = offsets[j];
+            while(a < offsets[i+1] && b < offsets[j+1])
+            {
+                if(targets[a] < targets[b])
+                    a++;
+                else if(targets[a] > targets[b])
+                    b++;
+                else
+                {
+                    links++;
+                    a++;
+                    b++;
+                }
+            }
+        }
+        // Every link between two neighbors was found twice
+        links /= 2;
+        if(k > 1)
+            localClustering[i] = 2.0*links/(k*(k-1));
+        triangles += links;
+        triples += k*(k-1)/2;
+        sum += localClustering[i];
+    }
+    averageClustering = nodes > 0 ? sum/nodes : 0;
+    globalClustering = triples > 0 ? triangles/triples : 0;
+}
+
+// Degree correlations along the edges: out degree of the source against
+// in degree of the target, and undirected degree at both ends
+void Statistics::computeAssortativity()
+{
+    const std::vector<int64_t>& offsets = output.getOffsets();
+    const std::vector<int32_t>& targets = output.getTargets();
+    const std::vector<int64_t>& uoffsets = undirected.getOffsets();
+    const std::vector<int32_t>& utargets = undirected.getTargets();
+    int nodes = output.getNodeCount();
+    double sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+    double ux = 0, uxx = 0, uxy = 0;
+
+    #pragma omp parallel for schedule(dynamic, 256) reduction(+:sx,sy,sxx,syy,sxy,ux,uxx,uxy)
+    for(int i = 0; i < nodes; i++)
+    {
+        double x = outDegree[i], u = undirectedDegree[i];
+        for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+        {
+            double y = inDegree[targets[e]];
+            sx += x;
+            sy += y;
+            sxx += x*x;
+            syy += y*y;
+            sxy += x*y;
+        }
+        for(int64_t e = uoffsets[i]; e < uoffsets[i+1]; e++)
+        {
+            double v = undirectedDegree[utargets[e]];
+            ux += u;
+            uxx += u*u;
+            uxy += u*v;
+        }
+    }
+    outInAssortativity = pearson(output.getEdgeCount(), sx, sy, sxx, syy, sxy);
+    // Both directions of every edge are in the sums, so x and y share them
+    undirectedAssortativity = pearson(undirected.getEdgeCount(), ux, ux, uxx, uxx, uxy);
+}
+
+// Directed breadth first searches from a random sample of sources
+void Statistics::computePaths(int samples, gsl_rng* rng)
+{
+    const std::vector<int64_t>& offsets = output.getOffsets();
+    const std::vector<int32_t>& targets = output.getTargets();
+    int nodes = output.getNodeCount();
+    std::vector<int> sources(nodes);
+    double total = 0, reached = 0;
+
+    for(int i = 0; i < nodes; i++)
+        sources[i] = i;
+    if(samples > 0 && samples < nodes)
+    {
+        std::vector<int> all(sources);
+        sources.resize(samples);
+        gsl_ran_choose(rng, &sources[0], samples, &all[0], nodes, sizeof(int));
+    }
+    pathSources = sources.size();
+    pathLengths.clear();
+
+    #pragma omp parallel reduction(+:total,reached)
+    {
+        std::vector<int> distance(nodes, -1);
+        std::vector<int32_t> queue(nodes);
+        std::vector<int64_t> lengths;
+
+        #pragma omp for schedule(dynamic)
+        for(int s = 0; s < int(sources.size()); s++)
+        {
+            size_t head = 0, tail = 0;
+            std::fill(distance.begin(), distance.end(), -1);
+            distance[sources[s]] = 0;
+            queue[tail++] = sources[s];
+            while(head < tail)
+            {
+                int32_t i = queue[head++];
+                for(int64_t e = offsets[i]; e < offsets[i+1]; e++)
+                {
+                    int32_t j = targets[e];
+                    if(distance[j] < 0)
+                    {
+                        distance[j] = distance[i]+1;
+                        queue[tail++] = j;
+                        if(int(lengths.size()) <= distance[j])
+                            lengths.resize(distance[j]+1, 0);
+                        lengths[distance[j]]++;
+                        total += distance[j];
+                        reached++;
+                    }
+                }
+            }
+        }
+
+        #pragma omp critical
+        {
+            if(pathLengths.size() < lengths.size())
+                pathLengths.resize(lengths.size(), 0);
+            for(size_t d = 0; d < lengths.size(); d++)
+                pathLengths[d] += lengths[d];
+        }
+    }
+    meanPathLength = reached > 0 ? total/reached : 0;
+    reachableFraction = nodes > 1 ? reached/(double(pathSources)*(nodes-1)) : 0;
+}
+
+std::vector<int64_t> Statistics::histogram(const std::vector<int>& values)
+{
+    std::vector<int64_t> counts;
+    for(std::vector<int>::const_iterator i = values.begin(); i != values.end(); i++)
+    {
+        if(int(counts.size()) <= *i)
+            counts.resize(*i+1, 0);
+        counts[*i]++;
+    }
+    return counts;
+}
+
+// Plain text summary: scalar metrics first, then one line per histogram
+// with the counts for 0, 1, 2...
+bool Statistics::save(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+    std::vector<int64_t> counts;
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    savedFile.precision(10);
+    savedFile << "% Network statistics\n";
+    savedFile << "nodes " << output.getNodeCount() << "\n";
+    savedFile << "edges " << output.getEdgeCount() << "\n";
+    savedFile << "undirected_edges " << undirected.getEdgeCount()/2 << "\n";
+    if(computed & neuron::STATS_RECIPROCITY)
+        savedFile << "reciprocity " << reciprocity << "\n";
+    if(computed & neuron::STATS_CLUSTERING)
+    {
+        savedFile << "average_clustering " << averageClustering << "\n";
+        savedFile << "global_clustering " << globalClustering << "\n";
+    }
+    if(computed & neuron::STATS_ASSORTATIVITY)
+    {
+        savedFile << "assortativity_out_in " << outInAssortativity << "\n";
+        savedFile << "assortativity_undirected " << undirectedAssortativity << "\n";
+    }
+    if(computed & neuron::STATS_PATHS)
+    {
+        savedFile << "path_sources " << pathSources << "\n";
+        savedFile << "mean_path_length " << meanPathLength << "\n";
+        savedFile << "reachable_fraction " << reachableFraction << "\n";
+    }
+
+    savedFile << "% Histograms, counts for 0, 1, 2...\n";
+    const char* names[3] = {"out_degree", "in_degree", "undirected_degree"};
+    const std::vector<int>* degrees[3] = {&outDegree, &inDegree, &undirectedDegree};
+    for(int h = 0; h < 3; h++)
+    {
+        counts = histogram(*degrees[h]);
+        savedFile << names[h];
+        for(std::vector<int64_t>::iterator i = counts.begin(); i != counts.end(); i++)
+            savedFile << " " << *i;
+        savedFile << "\n";
+    }
+    if(computed & neuron::STATS_PATHS)
+    {
+        savedFile << "path_length";
+        for(std::vector<int64_t>::iterator i = pathLengths.begin(); i != pathLengths.end(); i++)
+            savedFile << " " << *i;
+        savedFile << "\n";
+    }
+    savedFile.close();
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _STATISTICS_H_
+#define _STATISTICS_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "gsl/gsl_rng.h"
+#include "adjacency.h"
+#include "neuronnamespace.h"
+
+// Summary statistics of a generated network, computed in parallel over
+// the CSR adjacency. Directed metrics use the output connections, the
+// undirected ones the symmetrized graph without repeated edges.
+class Statistics
+{
+    public:
+        Statistics(const Adjacency& adjacency);
+        void compute(int metrics, int pathSamples, gsl_rng* rng);
+        bool save(std::string fileName);
+        inline double getReciprocity()
+            {return reciprocity;}
+        inline double getAverageClustering()
+            {return averageClustering;}
+        inline double getGlobalClustering()
+            {return globalClustering;}
+        inline const std::vector<double>& getLocalClustering()
+            {return localClustering;}
+
+    private:
+        void computeDegrees();
+        void computeReciprocity();
+        void computeClustering();
+        void computeAssortativity();
+        void computePaths(int samples, gsl_rng* rng);
+        static std::vector<int64_t> histogram(const std::vector<int>& values);
+
+        int computed;
+        Adjacency output, input, undirected;
+        std::vector<int> outDegree, inDegree, undirectedDegree;
+        double reciprocity;
+        std::vector<double> localClustering;
+        double averageClustering, globalClustering;
+        double outInAssortativity, undirectedAssortativity;
+        int pathSources;
+        double meanPathLength, reachableFraction;
+        std::vector<int64_t> pathLengths;
+};
+
+#endif
+    // _STATISTICS_H_
+
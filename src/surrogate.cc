@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include "gsl/gsl_rng.h"
+#include "chamber.h"
+#include "random.h"
+#include "surrogate.h"
+
+// Names of the summary statistics in the report
+static const char* const SUMMARY_NAMES[] = {"neurons", "connections", "mean_degree", "std_out_degree",
+                                            "std_in_degree", "reciprocity", "mean_length"};
+
+Surrogate::Surrogate(double bin, double distance)
+{
+    binWidth = bin;
+    maxDistance = distance;
+    bins = binWidth > 0 ? int(ceil(maxDistance/binWidth)) : 0;
+    calibrationRuns = 0;
+    exactConnections = exactCovered = 0;
+    for(int t = 0; t < PAIR_TYPES; t++)
+    {
+        candidates[t].assign(bins, 0);
+        connected[t].assign(bins, 0);
+    }
+    exact.assign(SUMMARY_COUNT, 0.);
+    surrogate.assign(SUMMARY_COUNT, 0.);
+}
+
+// Adds the pairs of an exactly connected chamber to the kernel. Several
+// runs are accumulated, their summaries are averaged
+void Surrogate::calibrate(Chamber* chamber)
+{
+    int count = chamber->neuron.size();
+    int64_t covered = 0, total = 0;
+    std::vector<double> summary = summarize(chamber);
+
+    chamber->buildSomaGrid(maxDistance);
+    #pragma omp parallel reduction(+:covered, total)
+    {
+        std::vector<int64_t> localCandidates[PAIR_TYPES], localConnected[PAIR_TYPES];
+        for(int t = 0; t < PAIR_TYPES; t++)
+        {
+            localCandidates[t].assign(bins, 0);
+            localConnected[t].assign(bins, 0);
+        }
+
+        #pragma omp for schedule(dynamic, 64)
+        for(int i = 0; i < count; i++)
+        {
+            Vector2d position = chamber->neuron[i].getPosition();
+            std::vector<int> somas = chamber->getSomasInRange(i, maxDistance);
+            std::vector<Neuron*> outputs = chamber->neuron[i].getOutputConnections();
+            std::vector<int> targets;
+
+            for(std::vector<Neuron*>::iterator j = outputs.begin(); j != outputs.end(); j++)
+                targets.push_back((*j)->getIndex());
+            std::sort(targets.begin(), targets.end());
+            total += targets.size();
+            for(std::vector<int>::iterator j = somas.begin(); j != somas.end(); j++)
+            {
+                Vector2d other = chamber->neuron[*j].getPosition();
+                int bin = int((other-position).norm()/binWidth);
+                int type;
+                if(bin >= bins)
+                    continue;
+                type = chamber->lineOfSight(position, other) ? PAIRS_CLEAR : PAIRS_BLOCKED;
+                localCandidates[type][bin]++;
+                if(std::binary_search(targets.begin(), targets.end(), *j))
+                {
+                    localConnected[type][bin]++;
+                    covered++;
+                }
+            }
+        }
+
+        #pragma omp critical (surrogateKernel)
+        for(int t = 0; t < PAIR_TYPES; t++)
+        {
+            for(int b = 0; b < bins; b++)
+            {
+                candidates[t][b] += localCandidates[t][b];
+                connected[t][b] += localConnected[t][b];
+            }
+        }
+    }
+    exactConnections += total;
+    exactCovered += covered;
+
+    for(int k = 0; k < SUMMARY_COUNT; k++)
+        exact[k] = (exact[k]*calibrationRuns+summary[k])/(calibrationRuns+1);
+    calibrationRuns++;
+}
+
+double Surrogate::probability(int type, int bin)
+{
+    return candidates[type][bin] > 0 ? double(connected[type][bin])/candidates[type][bin] : 0.;
+}
+
+// Replaces the connections of the chamber with ones sampled from the
+// kernel. Neuron i draws from its own stream, so the network only depends
+// on the seed
+void Surrogate::connect(Chamber* chamber, int seed)
+{
+    int count = chamber->neuron.size();
+    std::vector<double> kernel[PAIR_TYPES];
+
+    for(int t = 0; t < PAIR_TYPES; t++)
+        for(int b = 0; b < bins; b++)
+            kernel[t].push_back(probability(t, b));
+
+    std::cout << "Sampling surrogate connections...\n";
+    chamber->buildSomaGrid(maxDistance);
+    #pragma omp parallel
+    {
+        gsl_rng* stream = gsl_rng_alloc(gsl_rng_taus2);
+
+        #pragma omp for schedule(dynamic, 64)
+        for(int i = 0; i < count; i++)
+        {
+            Vector2d position = chamber->neuron[i].getPosition();
+            std::vector<int> somas = chamber->getSomasInRange(i, maxDistance);
+            std::vector<Neuron*> outputs;
+
+            gsl_rng_set(stream, Random::streamSeed(seed, i));
+            for(std::vector<int>::iterator j = somas.begin(); j != somas.end(); j++)
+            {
+                Vector2d other = chamber->neuron[*j].getPosition();
+                int bin = int((other-position).norm()/binWidth);
+                double p;
+                if(bin >= bins)
+                    continue;
+                // The line of sight is only traced when it matters
+                if(kernel[PAIRS_CLEAR][bin] == kernel[PAIRS_BLOCKED][bin])
+                    p = kernel[PAIRS_CLEAR][bin];
+                else
+                    p = kernel[chamber->lineOfSight(position, other) ? PAIRS_CLEAR : PAIRS_BLOCKED][bin];
+                if(gsl_rng_uniform(stream) < p)
+                    outputs.push_back(&chamber->neuron[*j]);
+            }
+            chamber->neuron[i].setOutputConnections(outputs);
+        }
+        gsl_rng_free(stream);
+    }
+    chamber->assignInputConnections();
+    surrogate = summarize(chamber);
+}
+
+std::vector<double> Surrogate::summarize(Chamber* chamber)
+{
+    std::vector<double> summary(SUMMARY_COUNT);
+    double meanDegree;
+    int count = chamber->neuron.size();
+    std::vector<std::vector<int> > outputs(count);
+    double sumOut = 0, sumOutSquares = 0, sumInSquares = 0, length = 0;
+    int64_t reciprocal = 0, total = 0;
+
+    #pragma omp parallel for schedule(dynamic, 256)
+    for(int i = 0; i < count; i++)
+    {
+        std::vector<Neuron*> connections = chamber->neuron[i].getOutputConnections();
+        for(std::vector<Neuron*>::iterator j = connections.begin(); j != connections.end(); j++)
+            outputs[i].push_back((*j)->getIndex());
+        std::sort(outputs[i].begin(), outputs[i].end());
+    }
+
+    #pragma omp parallel for reduction(+:sumOut, sumOutSquares, sumInSquares, length, reciprocal, total)
+    for(int i = 0; i < count; i++)
+    {
+        double out = outputs[i].size(), in = chamber->neuron[i].getInputConnections().size();
+        sumOut += out;
+        sumOutSquares += out*out;
+        sumInSquares += in*in;
+        for(std::vector<int>::iterator j = outputs[i].begin(); j != outputs[i].end(); j++)
+        {
+            length += (chamber->neuron[*j].getPosition()-chamber->neuron[i].getPosition()).norm();
+            if(std::binary_search(outputs[*j].begin(), outputs[*j].end(), i))
+                reciprocal++;
+            total++;
+        }
+    }
+
+    meanDegree = count > 0 ? sumOut/count : 0;
+    summary[SUMMARY_NEURONS] = count;
+    summary[SUMMARY_CONNECTIONS] = total;
+    summary[SUMMARY_MEAN_DEGREE] = meanDegree;
+    summary[SUMMARY_STD_OUT_DEGREE] = count > 0 ? sqrt(std::max(0., sumOutSquares/count-meanDegree*meanDegree)) : 0;
+    summary[SUMMARY_STD_IN_DEGREE] = count > 0 ? sqrt(std::max(0., sumInSquares/count-meanDegree*meanDegree)) : 0;
+    summary[SUMMARY_RECIPROCITY] = total > 0 ? double(reciprocal)/total : 0;
+    summary[SUMMARY_MEAN_LENGTH] = total > 0 ? length/total : 0;
+    return summary;
+}
+
+// Kernel table and the statistics of the exact (averaged over the
+// calibration runs) and surrogate networks
+bool Surrogate::saveReport(std::string fileName)
+{
+    std::ofstream savedFile(fileName.c_str());
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << fileName;
+        return false;
+    }
+    savedFile.precision(10);
+    savedFile << "% Surrogate network report, kernel from " << calibrationRuns << " exact runs\n";
+    savedFile << "% Exact connections within the kernel range: " << exactCovered << " of " << exactConnections << "\n";
+    savedFile << "% statistic exact surrogate\n";
+    for(int k = 0; k < SUMMARY_COUNT; k++)
+        savedFile << "% " << SUMMARY_NAMES[k] << " " << exact[k] << " " << surrogate[k] << "\n";
+    savedFile << "% distance_from distance_to clear_pairs clear_connected clear_probability"
+              << " blocked_pairs blocked_connected blocked_probability\n";
+    for(int b = 0; b < bins; b++)
+    {
+        savedFile << b*binWidth << " " << (b+1)*binWidth;
+        for(int t = 0; t < PAIR_TYPES; t++)
+            savedFile << " " << candidates[t][b] << " " << connected[t][b] << " " << probability(t, b);
+        savedFile << "\n";
+    }
+    savedFile.close();
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _SURROGATE_H_
+#define _SURROGATE_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "neuronnamespace.h"
+
+class Chamber;
+
+// Connectivity sampled from a connection kernel instead of grown axons.
+// The kernel is the probability of a connection against soma distance,
+// measured on exact networks separately for the pairs with a clear line
+// of sight and the pairs whose line crosses the pattern. Connecting a
+// chamber only needs the somas, every neuron checks the somas of the
+// chamber soma grid around it, so the cost grows linearly with the size.
+class Surrogate
+{
+    public:
+        Surrogate(double bin, double distance);
+        void calibrate(Chamber* chamber);
+        void connect(Chamber* chamber, int seed);
+        bool saveReport(std::string fileName);
+
+    private:
+        enum { PAIRS_CLEAR, PAIRS_BLOCKED, PAIR_TYPES };
+        // Statistics compared in the report
+        enum { SUMMARY_NEURONS, SUMMARY_CONNECTIONS, SUMMARY_MEAN_DEGREE, SUMMARY_STD_OUT_DEGREE,
+               SUMMARY_STD_IN_DEGREE, SUMMARY_RECIPROCITY, SUMMARY_MEAN_LENGTH, SUMMARY_COUNT };
+        static std::vector<double> summarize(Chamber* chamber);
+        double probability(int type, int bin);
+
+        double binWidth, maxDistance;
+        int bins, calibrationRuns;
+        int64_t exactConnections, exactCovered;
+        std::vector<int64_t> candidates[PAIR_TYPES], connected[PAIR_TYPES];
+        std::vector<double> exact, surrogate;
+};
+
+#endif
+    // _SURROGATE_H_
+
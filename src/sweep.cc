@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "sweep.h"
+#include "network.h"
+#include "chamber.h"
+#include "checkpoint.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Orders the members of a family so points sharing their axons (and then
+// their dendrites) are generated one after the other
+typedef struct familyOrder
+{
+    std::vector<std::vector<uint64_t> >* keys;
+    familyOrder(std::vector<std::vector<uint64_t> >* k) : keys(k) {}
+    bool operator()(int a, int b) const
+    {
+        if((*keys)[a][neuron::STAGE_AXONS] != (*keys)[b][neuron::STAGE_AXONS])
+            return (*keys)[a][neuron::STAGE_AXONS] < (*keys)[b][neuron::STAGE_AXONS];
+        if((*keys)[a][neuron::STAGE_DENDRITES] != (*keys)[b][neuron::STAGE_DENDRITES])
+            return (*keys)[a][neuron::STAGE_DENDRITES] < (*keys)[b][neuron::STAGE_DENDRITES];
+        return a < b;
+    }
+} familyOrder;
+
+Sweep::Sweep()
+{
+    zip = false;
+    threads = 0;
+    seed = -1;
+    files = "sweep_%04d_";
+    manifestFile = "sweep_manifest.txt";
+}
+
+bool Sweep::load(libconfig::Config& config)
+{
+    bool active = false;
+    std::string mode;
+
+    if(!config.lookupValue("network.sweep.active", active) || !active)
+        return false;
+    if(config.lookupValue("network.sweep.mode", mode))
+    {
+        if(mode == "zip")
+            zip = true;
+        else if(mode != "cartesian")
+        {
+            std::cout << "Sweep error. Invalid mode: " << mode << "\n";
+            exit(1);
+        }
+    }
+    config.lookupValue("network.sweep.files", files);
+    config.lookupValue("network.sweep.manifest", manifestFile);
+    config.lookupValue("network.sweep.threads", threads);
+
+    if(!config.exists("network.sweep.parameters"))
+    {
+        std::cout << "Sweep error. No parameters set\n";
+        exit(1);
+    }
+    libconfig::Setting& list = config.lookup("network.sweep.parameters");
+    for(int i = 0; i < list.getLength(); i++)
+    {
+        libconfig::Setting& item = list[i];
+        sweepParameter param;
+        double from, to, step;
+
+        if(!item.lookupValue("key", param.key) || !config.exists(param.key.c_str()))
+        {
+            std::cout << "Sweep error. Parameter " << i << " does not name an existing setting\n";
+            exit(1);
+        }
+        if(!config.lookup(param.key.c_str()).isNumber())
+        {
+            std::cout << "Sweep error. Only numeric settings can be swept: " << param.key << "\n";
+            exit(1);
+        }
+        if(item.exists("values"))
+        {
+            libconfig::Setting& values = item["values"];
+            for(int j = 0; j < values.getLength(); j++)
+                param.values.push_back(double(values[j]));
+        }
+        else if(item.lookupValue("from", from) && item.lookupValue("to", to) && item.lookupValue("step", step) && step > 0)
+        {
+            // Inclusive range, tolerant to rounding in the last step
+            for(int j = 0; from+j*step <= to+1e-9*step; j++)
+                param.values.push_back(from+j*step);
+        }
+        if(param.values.empty())
+        {
+            std::cout << "Sweep error. Parameter " << param.key << " needs a values list or from, to and step\n";
+            exit(1);
+        }
+        parameters.push_back(param);
+    }
+    if(parameters.empty())
+    {
+        std::cout << "Sweep error. No parameters set\n";
+        exit(1);
+    }
+    createPoints();
+    return true;
+}
+
+void Sweep::createPoints()
+{
+    std::vector<size_t> index(parameters.size(), 0);
+    std::vector<double> point(parameters.size());
+
+    points.clear();
+    if(zip)
+    {
+        for(size_t i = 1; i < parameters.size(); i++)
+        {
+            if(parameters[i].values.size() != parameters[0].values.size())
+            {
+                std::cout << "Sweep error. All parameters need the same number of values in zip mode\n";
+                exit(1);
+            }
+        }
+        for(size_t j = 0; j < parameters[0].values.size(); j++)
+        {
+            for(size_t i = 0; i < parameters.size(); i++)
+                point[i] = parameters[i].values[j];
+            points.push_back(point);
+        }
+        return;
+    }
+
+    // Cartesian product, the last parameter changes fastest
+    while(true)
+    {
+        size_t i;
+        for(i = 0; i < parameters.size(); i++)
+            point[i] = parameters[i].values[index[i]];
+        points.push_back(point);
+        for(i = parameters.size(); i > 0; i--)
+        {
+            if(++index[i-1] < parameters[i-1].values.size())
+                break;
+            index[i-1] = 0;
+        }
+        if(i == 0)
+            break;
+    }
+}
+
+// Writes the values of point p into the config, keeping the setting type
+bool Sweep::applyPoint(libconfig::Config& config, int p)
+{
+    for(size_t i = 0; i < parameters.size(); i++)
+    {
+        libconfig::Setting& setting = config.lookup(parameters[i].key.c_str());
+        if(setting.getType() == libconfig::Setting::TypeInt || setting.getType() == libconfig::Setting::TypeInt64)
+            setting = int(floor(points[p][i]+0.5));
+        else
+            setting = points[p][i];
+    }
+    return true;
+}
+
+void Sweep::run(libconfig::Config& config, Network& reference)
+{
+    std::map<uint64_t, Network*> bases;
+    std::map<uint64_t, std::vector<int> > families;
+    std::vector<std::vector<int> > familyList;
+    uint64_t stageKeys[neuron::STAGE_COUNT];
+    int finished = 0;
+
+    // All points share the seed, so they only differ by their parameters
+    reference.seedRNG(reference.fixedSeed);
+    seed = reference.seed;
+    std::cout << "Sweeping " << points.size() << " points with seed " << seed << "\n";
+
+    network.resize(points.size());
+    pointBase.resize(points.size());
+    keys.resize(points.size());
+    prefixes.resize(points.size());
+    for(size_t p = 0; p < points.size(); p++)
+    {
+        char prefix[FILENAME_MAX];
+        Network* point = new Network();
+
+        applyPoint(config, p);
+        point->parseConfig(config);
+        point->seed = seed;
+        point->resume = false;
+        point->checkpointActive = false;
+        point->cache = StageCache();
+        point->computeStageKeys(stageKeys);
+        keys[p].assign(stageKeys, stageKeys+neuron::STAGE_COUNT);
+        snprintf(prefix, FILENAME_MAX, files.c_str(), int(p));
+        prefixes[p] = prefix;
+        network[p] = point;
+
+        // One preprocessed chamber per distinct pattern and density map
+        if(bases.find(keys[p][neuron::STAGE_DENSITY_MAP]) == bases.end())
+        {
+            Network* base = new Network();
+            base->parseConfig(config);
+            if(!base->buildChamber())
+            {
+                std::cout << "Sweep error. Could not build the chamber of point " << p << "\n";
+                exit(1);
+            }
+            base->seedRNG(seed);
+            base->chamber->assignLattice();
+            base->runStage(neuron::STAGE_PATTERN);
+            base->runStage(neuron::STAGE_DENSITY_MAP);
+            bases[keys[p][neuron::STAGE_DENSITY_MAP]] = base;
+        }
+        pointBase[p] = bases[keys[p][neuron::STAGE_DENSITY_MAP]];
+        families[keys[p][neuron::STAGE_PLACEMENT]].push_back(p);
+    }
+    for(std::map<uint64_t, std::vector<int> >::iterator i = families.begin(); i != families.end(); i++)
+    {
+        std::sort(i->second.begin(), i->second.end(), familyOrder(&keys));
+        familyList.push_back(i->second);
+    }
+    std::cout << "Sweep uses " << bases.size() << " chambers and " << familyList.size() << " placements\n";
+
+#ifdef _OPENMP
+    if(threads > 0)
+        omp_set_num_threads(threads);
+#endif
+    #pragma omp parallel for schedule(dynamic)
+    for(int f = 0; f < int(familyList.size()); f++)
+    {
+        runFamily(familyList[f]);
+
+        #pragma omp critical
+        {
+            finished += familyList[f].size();
+            std::cout << "Sweep family " << f << " done (" << finished << "/" << points.size() << ")\n";
+        }
+    }
+
+    saveManifest();
+    for(std::map<uint64_t, Network*>::iterator i = bases.begin(); i != bases.end(); i++)
+        delete i->second;
+}
+
+// Generates the points of one family in order. The state after a stage is
+// kept in memory only while a later member still shares its key
+void Sweep::runFamily(std::vector<int>& members)
+{
+    std::map<uint64_t, Checkpoint> snapshots;
+
+    for(size_t m = 0; m < members.size(); m++)
+    {
+        int p = members[m];
+        int completed = neuron::STAGE_DENSITY_MAP;
+        Network* point = network[p];
+
+        point->chamber = pointBase[p]->chamber->createRealization();
+        point->chamber->setCultureParameters(point->cultureParams);
+        point->chamber->setNeuronParameters(point->somaParams, point->dtreeParams, point->axonParams);
+        point->seedRNG(seed);
+
+        for(int stage = neuron::STAGE_CONNECTIONS; stage >= neuron::STAGE_PLACEMENT; stage--)
+        {
+            if(snapshots.find(keys[p][stage]) != snapshots.end())
+            {
+                if(!snapshots[keys[p][stage]].restore(point->chamber, point->rng))
+                    exit(1);
+                completed = stage;
+                break;
+            }
+        }
+        for(int stage = completed+1; stage < neuron::STAGE_COUNT; stage++)
+        {
+            point->runStage(stage);
+            for(size_t n = m+1; n < members.size(); n++)
+            {
+                if(keys[members[n]][stage] == keys[p][stage])
+                {
+                    snapshots[keys[p][stage]].capture(stage, seed, point->rng, point->chamber);
+                    break;
+                }
+            }
+        }
+
+        // Drop the snapshots no later member can use
+        for(std::map<uint64_t, Checkpoint>::iterator i = snapshots.begin(); i != snapshots.end();)
+        {
+            bool used = false;
+            for(size_t n = m+1; n < members.size() && !used; n++)
+                used = std::find(keys[members[n]].begin(), keys[members[n]].end(), i->first) != keys[members[n]].end();
+            if(used)
+                i++;
+            else
+                snapshots.erase(i++);
+        }
+
+        point->saveOutputs(prefixes[p]);
+        delete point;
+        network[p] = NULL;
+    }
+}
+
+void Sweep::saveManifest()
+{
+    std::ofstream savedFile(manifestFile.c_str());
+
+    if (!savedFile.is_open())
+    {
+        std::cout << "There was an error opening file " << manifestFile;
+        return;
+    }
+    savedFile << "% Parameter sweep. Seed: " << seed << "\n";
+    savedFile << "% point";
+    for(size_t i = 0; i < parameters.size(); i++)
+        savedFile << " " << parameters[i].key;
+    savedFile << " prefix\n";
+    savedFile.precision(17);
+    for(size_t p = 0; p < points.size(); p++)
+    {
+        savedFile << p;
+        for(size_t i = 0; i < parameters.size(); i++)
+            savedFile << " " << points[p][i];
+        savedFile << " " << prefixes[p] << "\n";
+    }
+    savedFile.close();
+}
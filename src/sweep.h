@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2009-2013 Javier G. Orlandi <javiergorlandi@gmail.com>
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef _SWEEP_H_
+#define _SWEEP_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <libconfig.h++>
+#include "neuronnamespace.h"
+
+class Network;
+
+// Parameter sweep over numeric config.cfg fields. Every point is parsed
+// into its own Network and hashed with the stage keys of the stage cache.
+// Points with the same pattern and density map share one preprocessed
+// chamber, and points with the same placement form a family that is
+// generated by a single thread, reusing in memory the placement, axons and
+// dendrites of earlier members whenever their keys match. Families run in
+// parallel.
+class Sweep
+{
+    public:
+        Sweep();
+        bool load(libconfig::Config& config);
+        void run(libconfig::Config& config, Network& reference);
+
+    private:
+        typedef struct sweepParameter
+        {
+            std::string key;
+            std::vector<double> values;
+        } sweepParameter;
+
+        void createPoints();
+        bool applyPoint(libconfig::Config& config, int p);
+        void runFamily(std::vector<int>& members);
+        void saveManifest();
+
+        bool zip;
+        int threads, seed;
+        std::string files, manifestFile;
+        std::vector<sweepParameter> parameters;
+        std::vector<std::vector<double> > points;
+        std::vector<std::vector<uint64_t> > keys;
+        std::vector<Network*> network;
+        std::vector<Network*> pointBase;
+        std::vector<std::string> prefixes;
+};
+
+#endif
+    // _SWEEP_H_
+